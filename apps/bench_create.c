@@ -0,0 +1,93 @@
+/*
+ * Thread creation benchmark
+ *
+ * Fans out the same number of trivial threads and waits for all of them to
+ * finish, first creating them one uthread_create() at a time, then with a
+ * single uthread_create_batch(). Each way is repeated, and the best cost per
+ * thread is reported.
+ *
+ * Usage: bench_create.x [num_threads] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define NUM_THREADS	10000
+#define ROUNDS		5
+
+struct bench {
+	size_t num_threads;
+	size_t rounds;
+	uthread_func_t *funcs;
+	size_t done;
+	double one_by_one;
+	double batch;
+};
+
+struct bench bench;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void count(void *arg)
+{
+	bench.done++;
+}
+
+static double fan_out(int batch)
+{
+	double start = now();
+
+	bench.done = 0;
+	if (batch) {
+		uthread_create_batch(bench.num_threads, bench.funcs, NULL, NULL);
+	} else {
+		for (size_t i = 0; i < bench.num_threads; i++)
+			uthread_create(count, NULL);
+	}
+
+	while (bench.done < bench.num_threads)
+		uthread_yield();
+
+	return (now() - start) * 1e9 / bench.num_threads;
+}
+
+static void client(void *arg)
+{
+	for (size_t r = 0; r < bench.rounds; r++) {
+		double one_by_one = fan_out(0);
+		double batch = fan_out(1);
+
+		if (r == 0 || one_by_one < bench.one_by_one)
+			bench.one_by_one = one_by_one;
+		if (r == 0 || batch < bench.batch)
+			bench.batch = batch;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	bench.num_threads = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_THREADS;
+	bench.rounds = argc > 2 ? strtoul(argv[2], NULL, 0) : ROUNDS;
+	bench.funcs = malloc(bench.num_threads * sizeof(uthread_func_t));
+	for (size_t i = 0; i < bench.num_threads; i++)
+		bench.funcs[i] = count;
+
+	uthread_start(client, NULL);
+
+	printf("threads: %zu\n", bench.num_threads);
+	printf("uthread_create(): %.1f ns/thread\n", bench.one_by_one);
+	printf("uthread_create_batch(): %.1f ns/thread\n", bench.batch);
+
+	free(bench.funcs);
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Deadline miss rate benchmark
+ *
+ * CPU-bound worker threads, without deadlines, release events to handler
+ * threads as they go, one every PERIOD. Each handler waits for its events on
+ * a semaphore, and must have processed an event within DEADLINE of its
+ * release. The run is made under the FIFO policy, where a woken handler waits
+ * its turn behind the workers, and under the EDF policy, where it preempts
+ * them. The share of events handled past their deadline is reported for each.
+ *
+ * Usage: bench_edf.x [duration_ms]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_WORKERS	4
+#define NUM_HANDLERS	4
+#define DURATION_MS	500
+
+/* Time between two events, deadline and work of each of them (in ns) */
+#define PERIOD		500000ULL
+#define DEADLINE	1000000ULL
+#define HANDLER_WORK	100000ULL
+
+/* Work done by a worker between two checks for due events (in ns) */
+#define WORKER_WORK	20000ULL
+
+struct handler {
+	sem_t events;
+	uint64_t release;
+	size_t handled;
+	size_t missed;
+};
+
+struct handler handlers[NUM_HANDLERS];
+uint64_t end_time;
+uint64_t next_release;
+size_t num_released;
+int stopping;
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void spin(uint64_t ns)
+{
+	uint64_t until = now() + ns;
+
+	while(now() < until)
+		;
+}
+
+static void handler(void *arg)
+{
+	struct handler *h = arg;
+
+	uthread_set_deadline(DEADLINE);
+
+	for (;;) {
+		sem_down(h->events);
+		if (stopping)
+			break;
+
+		spin(HANDLER_WORK);
+
+		h->handled++;
+		if (now() > h->release + DEADLINE)
+			h->missed++;
+	}
+}
+
+static void worker(void *arg)
+{
+	while (now() < end_time) {
+		spin(WORKER_WORK);
+
+		/* Release the event that is due, if any */
+		if (now() >= next_release) {
+			struct handler *h = &handlers[num_released++ % NUM_HANDLERS];
+
+			next_release += PERIOD;
+			h->release = now();
+			sem_up(h->events);
+		}
+	}
+
+	/* The first worker done stops the handlers */
+	if (!stopping) {
+		stopping = 1;
+		for (int i = 0; i < NUM_HANDLERS; i++)
+			sem_up(handlers[i].events);
+	}
+}
+
+static void client(void *arg)
+{
+	for (int i = 0; i < NUM_HANDLERS; i++)
+		uthread_create(handler, &handlers[i]);
+	for (int i = 0; i < NUM_WORKERS; i++)
+		uthread_create(worker, NULL);
+}
+
+static void run(enum uthread_sched_policy policy, const char *name,
+		uint64_t duration_ms)
+{
+	uthread_opts_t opts;
+	size_t handled = 0, missed = 0;
+
+	for (int i = 0; i < NUM_HANDLERS; i++) {
+		handlers[i].events  = sem_create(0);
+		handlers[i].handled = 0;
+		handlers[i].missed  = 0;
+	}
+	stopping = 0;
+	num_released = 0;
+	next_release = now();
+	end_time = next_release + duration_ms * 1000000;
+
+	uthread_opts_init(&opts);
+	opts.policy = policy;
+	uthread_start_opts(&opts, client, NULL);
+
+	for (int i = 0; i < NUM_HANDLERS; i++) {
+		handled += handlers[i].handled;
+		missed += handlers[i].missed;
+		sem_destroy(handlers[i].events);
+	}
+
+	printf("%s: %zu events, %zu handled, %zu missed (%.1f%%)\n", name,
+	       num_released, handled, missed,
+	       handled ? 100.0 * missed / handled : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t duration_ms = argc > 1 ? strtoul(argv[1], NULL, 0) : DURATION_MS;
+
+	printf("workers: %d, handlers: %d, period: %llu us, deadline: %llu us\n",
+	       NUM_WORKERS, NUM_HANDLERS, PERIOD / 1000, DEADLINE / 1000);
+
+	run(UTHREAD_SCHED_FIFO, "fifo", duration_ms);
+	run(UTHREAD_SCHED_EDF, "edf", duration_ms);
+
+	return 0;
+}
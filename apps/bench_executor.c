@@ -0,0 +1,116 @@
+/*
+ * Executor benchmark
+ *
+ * Runs the same number of small jobs, first by creating a thread per job and
+ * waiting for all of them on a semaphore, then by submitting them to an
+ * executor and waiting on their futures, and reports the cost per job.
+ *
+ * Usage: bench_executor.x [num_jobs] [num_workers]
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <executor.h>
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_JOBS	100000
+#define NUM_WORKERS	8
+
+struct bench {
+	size_t num_jobs;
+	size_t num_workers;
+	sem_t finished;
+	future_t *futures;
+	volatile unsigned long sink;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *job(void *arg)
+{
+	struct bench *b = arg;
+
+	b->sink++;
+	return NULL;
+}
+
+static void thread_job(void *arg)
+{
+	struct bench *b = arg;
+
+	job(b);
+	sem_up(b->finished);
+}
+
+static void client(void *arg)
+{
+	struct bench *b = arg;
+	future_t *futures = b->futures;
+	executor_t executor;
+	double start, per_thread, per_executor;
+
+	/* One thread created per job */
+	start = now();
+	for (size_t i = 0; i < b->num_jobs; i++)
+		uthread_create(thread_job, b);
+	for (size_t i = 0; i < b->num_jobs; i++)
+		sem_down(b->finished);
+	per_thread = (now() - start) * 1e9 / b->num_jobs;
+
+	/* Jobs submitted to long-lived workers */
+	executor = executor_create(b->num_workers);
+	start = now();
+	for (size_t i = 0; i < b->num_jobs; i++)
+		futures[i] = executor_submit(executor, job, b);
+	for (size_t i = 0; i < b->num_jobs; i++)
+		future_wait(futures[i], NULL);
+	per_executor = (now() - start) * 1e9 / b->num_jobs;
+	executor_destroy(executor);
+
+	printf("jobs: %zu, workers: %zu\n", b->num_jobs, b->num_workers);
+	printf("create per job: %.1f ns/job\n", per_thread);
+	printf("executor: %.1f ns/job\n", per_executor);
+}
+
+static size_t get_argv(char *argv)
+{
+	long int ret = strtol(argv, NULL, 0);
+	if (ret == LONG_MIN || ret == LONG_MAX || ret <= 0) {
+		perror("strtol");
+		exit(1);
+	}
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b = {
+		.num_jobs = NUM_JOBS,
+		.num_workers = NUM_WORKERS,
+	};
+
+	if (argc > 1)
+		b.num_jobs = get_argv(argv[1]);
+	if (argc > 2)
+		b.num_workers = get_argv(argv[2]);
+
+	b.finished = sem_create(0);
+	b.futures = malloc(b.num_jobs * sizeof(future_t));
+
+	uthread_start(client, &b);
+
+	sem_destroy(b.finished);
+	free(b.futures);
+
+	return 0;
+}
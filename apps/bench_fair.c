@@ -0,0 +1,118 @@
+/*
+ * CPU share benchmark under mixed load
+ *
+ * Runs CPU-bound threads, which only switch through preemption, alongside
+ * threads doing short bursts of work and yielding in between. All of them
+ * would use the CPU all the time, so a fair scheduler would give each of them
+ * the same share. The share of each kind of thread and Jain's fairness index
+ * over all the threads are reported under the FIFO and FAIR policies.
+ *
+ * Usage: bench_fair.x [duration_ms]
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define NUM_HOGS	2
+#define NUM_YIELDERS	2
+#define NUM_THREADS	(NUM_HOGS + NUM_YIELDERS)
+#define DURATION_MS	500
+
+/* Work done by a yielder between two yields (in ns) */
+#define BURST		50000ULL
+
+uint64_t end_time;
+uint64_t cpu_time[NUM_THREADS];
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void record(long id)
+{
+	struct uthread_stats stats;
+
+	uthread_stats(&stats);
+	cpu_time[id] = stats.cpu_time_ns;
+}
+
+static void hog(void *arg)
+{
+	while (now() < end_time)
+		;
+
+	record((long) arg);
+}
+
+static void yielder(void *arg)
+{
+	while (now() < end_time) {
+		uint64_t burst_end = now() + BURST;
+
+		while (now() < burst_end)
+			;
+		uthread_yield();
+	}
+
+	record((long) arg);
+}
+
+static void client(void *arg)
+{
+	for (long i = 0; i < NUM_HOGS; i++)
+		uthread_create(hog, (void*) i);
+	for (long i = NUM_HOGS; i < NUM_THREADS; i++)
+		uthread_create(yielder, (void*) i);
+}
+
+static void run(enum uthread_sched_policy policy, const char *name,
+		uint64_t duration_ms)
+{
+	uthread_opts_t opts;
+	double total = 0, sum = 0, sum_sq = 0;
+	double hogs = 0, yielders = 0;
+
+	end_time = now() + duration_ms * 1000000;
+
+	uthread_opts_init(&opts);
+	opts.policy = policy;
+	uthread_start_opts(&opts, client, NULL);
+
+	for (int i = 0; i < NUM_THREADS; i++)
+		total += cpu_time[i];
+
+	for (int i = 0; i < NUM_THREADS; i++) {
+		double share = cpu_time[i] / total;
+
+		sum += share;
+		sum_sq += share * share;
+		if (i < NUM_HOGS)
+			hogs += share;
+		else
+			yielders += share;
+	}
+
+	printf("%s: hogs %.1f%%, yielders %.1f%%, fairness index %.2f\n", name,
+	       100 * hogs, 100 * yielders, sum * sum / (NUM_THREADS * sum_sq));
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t duration_ms = argc > 1 ? strtoul(argv[1], NULL, 0) : DURATION_MS;
+
+	printf("hogs: %d, yielders: %d, burst: %llu us\n", NUM_HOGS,
+	       NUM_YIELDERS, BURST / 1000);
+
+	run(UTHREAD_SCHED_FIFO, "fifo", duration_ms);
+	run(UTHREAD_SCHED_FAIR, "fair", duration_ms);
+
+	return 0;
+}
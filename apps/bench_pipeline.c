@@ -0,0 +1,145 @@
+/*
+ * Directed yield benchmark
+ *
+ * Runs a two-stage pipeline, a producer handing items one at a time to a
+ * consumer through a one-slot mailbox, alongside many background threads
+ * which keep yielding. Once it filled or emptied the mailbox, each stage
+ * gives way to the other, either with uthread_yield(), which goes through all
+ * the background threads first, or with uthread_yield_to(). Reports the
+ * mean latency of a handoff, from the time a stage filled or emptied the
+ * mailbox to the time the other stage found it so, and the item throughput.
+ *
+ * Usage: bench_pipeline.x [num_background] [num_items]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define NUM_BACKGROUND	1000
+#define NUM_ITEMS	20000
+
+size_t num_background;
+size_t num_items;
+int directed;
+
+/* Stages of the pipeline, the producer first */
+uthread_t stages[2];
+
+/* One-slot mailbox, and the time it was last filled or emptied */
+int full;
+double handed_at;
+
+size_t num_consumed;
+size_t num_handoffs;
+double total_latency;
+int done;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void hand_over(int to)
+{
+	if (directed)
+		uthread_yield_to(stages[to]);
+	else
+		uthread_yield();
+}
+
+static void producer(void *arg)
+{
+	for (size_t i = 0; i < num_items; i++) {
+		while (full)
+			hand_over(1);
+
+		if (i > 0) {
+			total_latency += now() - handed_at;
+			num_handoffs++;
+		}
+
+		full = 1;
+		handed_at = now();
+		hand_over(1);
+	}
+}
+
+static void consumer(void *arg)
+{
+	while (num_consumed < num_items) {
+		while (!full)
+			hand_over(0);
+
+		total_latency += now() - handed_at;
+		num_handoffs++;
+
+		full = 0;
+		num_consumed++;
+		handed_at = now();
+		hand_over(0);
+	}
+
+	done = 1;
+}
+
+static void background(void *arg)
+{
+	while (!done)
+		uthread_yield();
+}
+
+static void client(void *arg)
+{
+	uthread_func_t funcs[2] = { producer, consumer };
+
+	for (size_t i = 0; i < num_background; i++)
+		uthread_create(background, NULL);
+
+	uthread_create_batch(2, funcs, NULL, stages);
+}
+
+static void run(const char *name)
+{
+	uthread_opts_t opts;
+	double start, elapsed;
+
+	num_consumed = 0;
+	num_handoffs = 0;
+	total_latency = 0;
+	full = 0;
+	done = 0;
+
+	/* Keep the signal mask out of the way, to measure the switches */
+	uthread_opts_init(&opts);
+	opts.shared_sigmask = 1;
+
+	start = now();
+	uthread_start_opts(&opts, client, NULL);
+	elapsed = now() - start;
+
+	printf("%s: latency %.2f us, %.0f items/s\n", name,
+	       total_latency * 1e6 / num_handoffs, num_consumed / elapsed);
+}
+
+int main(int argc, char *argv[])
+{
+	num_background = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_BACKGROUND;
+	num_items = argc > 2 ? strtoul(argv[2], NULL, 0) : NUM_ITEMS;
+
+	printf("background threads: %zu, items: %zu\n", num_background,
+	       num_items);
+
+	directed = 0;
+	run("yield");
+
+	directed = 1;
+	run("yield_to");
+
+	return 0;
+}
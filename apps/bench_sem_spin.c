@@ -0,0 +1,112 @@
+/*
+ * Adaptive semaphore benchmark
+ *
+ * Has a few workers take turns on a lock semaphore, each holding it across a
+ * yield, as a thread preempted within its critical section would, while many
+ * idle threads stay blocked on another semaphore. Reports the cost of an
+ * acquisition and how waiters got the lock, first with waiters always
+ * blocking, then with waiters yielding for a while first (sem_set_spin()).
+ *
+ * Usage: bench_sem_spin.x [num_workers] [num_idle] [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_WORKERS	4
+#define NUM_IDLE	1000
+#define NUM_ROUNDS	20000
+#define MAX_YIELDS	16
+
+size_t num_workers;
+size_t num_idle;
+size_t num_rounds;
+
+sem_t lock;
+sem_t idle;
+size_t num_done;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void idler(void *arg)
+{
+	sem_down(idle);
+}
+
+static void worker(void *arg)
+{
+	for (size_t i = 0; i < num_rounds; i++) {
+		sem_down(lock);
+		uthread_yield();
+		sem_up(lock);
+		uthread_yield();
+	}
+
+	/* The last worker done releases the idle threads */
+	if (++num_done == num_workers) {
+		for (size_t i = 0; i < num_idle; i++)
+			sem_up(idle);
+	}
+}
+
+static void client(void *arg)
+{
+	for (size_t i = 0; i < num_idle; i++)
+		uthread_create(idler, NULL);
+
+	/* Let the idle threads block */
+	uthread_yield();
+
+	for (size_t i = 0; i < num_workers; i++)
+		uthread_create(worker, NULL);
+}
+
+static void run(const char *name, unsigned max_yields)
+{
+	struct sem_stats stats;
+	double start, elapsed;
+	size_t total = num_workers * num_rounds;
+
+	lock = sem_create_named(1, name);
+	idle = sem_create(0);
+	sem_set_spin(lock, max_yields);
+	num_done = 0;
+
+	start = now();
+	uthread_start(client, NULL);
+	elapsed = now() - start;
+
+	sem_stats(lock, &stats);
+	printf("%s: %.1f ns per acquisition, %llu blocked, %llu yielded\n",
+	       name, elapsed * 1e9 / total,
+	       (unsigned long long) stats.contended,
+	       (unsigned long long) stats.spun);
+
+	sem_destroy(idle);
+	sem_destroy(lock);
+}
+
+int main(int argc, char *argv[])
+{
+	num_workers = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_WORKERS;
+	num_idle = argc > 2 ? strtoul(argv[2], NULL, 0) : NUM_IDLE;
+	num_rounds = argc > 3 ? strtoul(argv[3], NULL, 0) : NUM_ROUNDS;
+
+	printf("workers: %zu, idle threads: %zu, rounds: %zu\n", num_workers,
+	       num_idle, num_rounds);
+
+	run("block", 0);
+	run("spin", MAX_YIELDS);
+
+	return 0;
+}
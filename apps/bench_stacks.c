@@ -0,0 +1,179 @@
+/*
+ * Stack mode benchmark
+ *
+ * Parks a large number of threads, each having used a small part of its
+ * stack, and reports the resident memory per parked thread. The threads are
+ * then woken up and yield a few times, to report the cost of a context switch,
+ * for threads with dedicated or shared stacks.
+ *
+ * Usage: bench_stacks.x [fixed|shared] [num_threads] [num_yields]
+ *
+ * Parking 1M threads takes about 3.2 GB of memory in shared mode, and 7 GB
+ * with dedicated stacks, hence the default of 10k threads.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_THREADS	10000
+#define NUM_YIELDS	10
+#define FRAME_SIZE	256
+#define STACK_DEPTH	4
+
+struct bench {
+	sem_t park;
+	size_t num_threads;
+	size_t num_yields;
+	size_t parked;
+	size_t done;
+	enum uthread_stack_mode mode;
+};
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Read with plain system calls, as stdio allocates memory */
+static long resident_bytes(void)
+{
+	char buf[64];
+	long size, resident;
+	ssize_t len;
+	int fd = open("/proc/self/statm", O_RDONLY);
+
+	if (fd < 0)
+		return -1;
+	len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (len <= 0)
+		return -1;
+
+	buf[len] = '\0';
+	if (sscanf(buf, "%ld %ld", &size, &resident) != 2)
+		return -1;
+
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Use a few frames of stack before parking, then yielding */
+static void use_stack(struct bench *b, int depth)
+{
+	volatile char frame[FRAME_SIZE];
+
+	memset((char *) frame, depth, FRAME_SIZE);
+	if (depth < STACK_DEPTH) {
+		use_stack(b, depth + 1);
+		return;
+	}
+
+	b->parked++;
+	sem_down(b->park);
+
+	for (size_t i = 0; i < b->num_yields; i++)
+		uthread_yield();
+
+	b->done++;
+}
+
+static void worker(void *arg)
+{
+	use_stack(arg, 0);
+}
+
+static void spawner(void *arg)
+{
+	struct bench *b = arg;
+	uthread_attr_t attr;
+	struct uthread_stats before, after;
+	double start, created, woken, done;
+	long rss_before, rss_after;
+	uint64_t switches;
+
+	uthread_attr_init(&attr);
+	attr.stack_mode = b->mode;
+
+	rss_before = resident_bytes();
+	start = now();
+
+	for (size_t i = 0; i < b->num_threads; i++) {
+		if (uthread_create_attr(&attr, worker, b)) {
+			fprintf(stderr, "thread creation failed at %zu\n", i);
+			exit(1);
+		}
+	}
+	created = now();
+
+	/* Parking phase: measure memory */
+	while (b->parked < b->num_threads)
+		uthread_yield();
+	rss_after = resident_bytes();
+
+	/* Yielding phase: measure switches */
+	uthread_stats_total(&before);
+	woken = now();
+
+	for (size_t i = 0; i < b->num_threads; i++)
+		sem_up(b->park);
+	while (b->done < b->num_threads)
+		uthread_yield();
+
+	done = now();
+	uthread_stats_total(&after);
+	switches = after.voluntary_switches + after.involuntary_switches -
+		before.voluntary_switches - before.involuntary_switches;
+
+	printf("mode: %s, threads: %zu, yields: %zu\n",
+	       b->mode == UTHREAD_STACK_SHARED ? "shared" : "fixed",
+	       b->num_threads, b->num_yields);
+	printf("creation: %.1f ns/thread\n",
+	       (created - start) * 1e9 / b->num_threads);
+	printf("resident: %ld bytes/parked thread\n",
+	       (rss_after - rss_before) / (long) b->num_threads);
+	printf("switch: %.1f ns/switch\n", (done - woken) * 1e9 / switches);
+}
+
+static size_t get_argv(char *argv)
+{
+	long int ret = strtol(argv, NULL, 0);
+	if (ret == LONG_MIN || ret == LONG_MAX || ret < 0) {
+		perror("strtol");
+		exit(1);
+	}
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b = {
+		.num_threads = NUM_THREADS,
+		.num_yields = NUM_YIELDS,
+		.mode = UTHREAD_STACK_FIXED,
+	};
+
+	if (argc > 1 && !strcmp(argv[1], "shared"))
+		b.mode = UTHREAD_STACK_SHARED;
+	if (argc > 2)
+		b.num_threads = get_argv(argv[2]);
+	if (argc > 3)
+		b.num_yields = get_argv(argv[3]);
+
+	b.park = sem_create(0);
+
+	uthread_start(spawner, &b);
+
+	sem_destroy(b.park);
+
+	return 0;
+}
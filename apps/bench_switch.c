@@ -0,0 +1,69 @@
+/*
+ * Context switch benchmark
+ *
+ * Two threads yield to each other, first with the default runtime options,
+ * then with the signal mask treated as process-wide, and the cost of a switch
+ * is reported for both.
+ *
+ * Usage: bench_switch.x [num_switches]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define NUM_SWITCHES	1000000
+
+size_t num_switches;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void yielder(void *arg)
+{
+	for (size_t i = 0; i < num_switches / 2; i++)
+		uthread_yield();
+}
+
+static void pair(void *arg)
+{
+	uthread_create(yielder, NULL);
+	yielder(NULL);
+}
+
+static double run(int shared_sigmask)
+{
+	uthread_opts_t opts;
+	double start;
+
+	uthread_opts_init(&opts);
+	opts.shared_sigmask = shared_sigmask;
+
+	start = now();
+	uthread_start_opts(&opts, pair, NULL);
+
+	return (now() - start) * 1e9 / num_switches;
+}
+
+int main(int argc, char *argv[])
+{
+	double per_thread, shared;
+
+	num_switches = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_SWITCHES;
+
+	per_thread = run(0);
+	shared = run(1);
+
+	printf("switches: %zu\n", num_switches);
+	printf("per-thread signal mask: %.1f ns/switch\n", per_thread);
+	printf("process-wide signal mask: %.1f ns/switch\n", shared);
+
+	return 0;
+}
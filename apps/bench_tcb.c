@@ -0,0 +1,129 @@
+/*
+ * TCB layout benchmark
+ *
+ * Blocks many threads, each on its own semaphore, then repeatedly wakes them
+ * up in reverse order, so that every wake-up walks the blocked threads.
+ * Reports the cost per wake-up and, when the hardware counters can be read,
+ * the cache misses per wake-up.
+ *
+ * Usage: bench_tcb.x [num_threads] [rounds]
+ */
+
+#include <linux/perf_event.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_THREADS	2000
+#define ROUNDS		20
+
+struct bench {
+	size_t num_threads;
+	size_t rounds;
+	sem_t *sems;
+	int perf_fd;
+	uint64_t elapsed_ns;
+	uint64_t misses;
+};
+
+struct bench bench;
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int perf_open(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+
+	return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static void sleeper(void *arg)
+{
+	sem_t sem = arg;
+
+	for (size_t r = 0; r < bench.rounds; r++)
+		sem_down(sem);
+}
+
+static void client(void *arg)
+{
+	uint64_t start, misses;
+
+	for (size_t i = 0; i < bench.num_threads; i++)
+		uthread_create(sleeper, bench.sems[i]);
+
+	/* Let every thread block on its semaphore */
+	uthread_yield();
+
+	for (size_t r = 0; r < bench.rounds; r++) {
+		if (bench.perf_fd >= 0) {
+			ioctl(bench.perf_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(bench.perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+
+		start = now();
+		for (size_t i = bench.num_threads; i-- > 0; )
+			sem_up(bench.sems[i]);
+		bench.elapsed_ns += now() - start;
+
+		if (bench.perf_fd >= 0) {
+			ioctl(bench.perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(bench.perf_fd, &misses, sizeof(misses)) ==
+			    sizeof(misses))
+				bench.misses += misses;
+		}
+
+		/* Run the woken up threads, which block again */
+		uthread_yield();
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t wakeups;
+
+	bench.num_threads = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_THREADS;
+	bench.rounds = argc > 2 ? strtoul(argv[2], NULL, 0) : ROUNDS;
+	bench.sems = malloc(bench.num_threads * sizeof(sem_t));
+	for (size_t i = 0; i < bench.num_threads; i++)
+		bench.sems[i] = sem_create(0);
+	bench.perf_fd = perf_open();
+
+	uthread_start(client, NULL);
+
+	wakeups = bench.num_threads * bench.rounds;
+	printf("threads: %zu, rounds: %zu\n", bench.num_threads, bench.rounds);
+	printf("wake-up: %.1f ns\n", (double) bench.elapsed_ns / wakeups);
+	if (bench.perf_fd >= 0)
+		printf("cache misses per wake-up: %.2f\n",
+		       (double) bench.misses / wakeups);
+	else
+		printf("cache misses per wake-up: unavailable\n");
+
+	for (size_t i = 0; i < bench.num_threads; i++)
+		sem_destroy(bench.sems[i]);
+	free(bench.sems);
+
+	return 0;
+}
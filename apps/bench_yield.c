@@ -0,0 +1,66 @@
+/*
+ * Yield throughput benchmark
+ *
+ * Makes many threads runnable at once, each of them yielding a number of
+ * times, and reports the cost of a yield and the yield throughput. With many
+ * threads, each yield goes through a ready queue holding all of them.
+ *
+ * Usage: bench_yield.x [num_threads] [yields_per_thread]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define NUM_THREADS	10000
+#define NUM_YIELDS	100
+
+size_t num_threads;
+size_t num_yields;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void yielder(void *arg)
+{
+	for (size_t i = 0; i < num_yields; i++)
+		uthread_yield();
+}
+
+static void client(void *arg)
+{
+	for (size_t i = 0; i < num_threads; i++)
+		uthread_create(yielder, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+	uthread_opts_t opts;
+	double start, elapsed;
+	size_t total;
+
+	num_threads = argc > 1 ? strtoul(argv[1], NULL, 0) : NUM_THREADS;
+	num_yields = argc > 2 ? strtoul(argv[2], NULL, 0) : NUM_YIELDS;
+
+	/* Keep the signal mask out of the way, to measure the queue */
+	uthread_opts_init(&opts);
+	opts.shared_sigmask = 1;
+
+	start = now();
+	uthread_start_opts(&opts, client, NULL);
+	elapsed = now() - start;
+
+	total = num_threads * num_yields;
+	printf("threads: %zu, yields per thread: %zu\n", num_threads, num_yields);
+	printf("yield: %.1f ns, %.2f M yields/s\n", elapsed * 1e9 / total,
+	       total / elapsed / 1e6);
+
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * Executor test
+ *
+ * Submits jobs to an executor with fewer workers than jobs, some of which
+ * block on a semaphore, and checks every future yields the result of its job.
+ * Then checks a job wakes a single parked worker, that a worker woken for a
+ * job another worker took parks again, and that destroying an executor
+ * releases all of its parked workers.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <executor.h>
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_WORKERS	3
+#define NUM_JOBS	16
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+sem_t gate;
+int destroyed;
+
+static void *square(void *arg)
+{
+	long x = (long) arg;
+
+	return (void *) (x * x);
+}
+
+static void *wait_gate(void *arg)
+{
+	sem_down(gate);
+	return arg;
+}
+
+static void *open_gate(void *arg)
+{
+	sem_up(gate);
+	return NULL;
+}
+
+static void *whoami(void *arg)
+{
+	return (void *) (uintptr_t) uthread_self();
+}
+
+static void *wait_gate_whoami(void *arg)
+{
+	sem_down(gate);
+	return whoami(arg);
+}
+
+/* Number of times the worker running the job parked so far */
+static void *num_parked(void *arg)
+{
+	struct uthread_stats stats;
+
+	uthread_stats(&stats);
+	return (void *) (uintptr_t) stats.voluntary_switches;
+}
+
+static void *wait_gate_num_parked(void *arg)
+{
+	void *result = num_parked(arg);
+
+	sem_down(gate);
+	return result;
+}
+
+static void client(void *arg)
+{
+	future_t futures[NUM_JOBS];
+	future_t blocked, opener;
+	executor_t executor;
+	void *result;
+	int correct = 0;
+
+	TEST_ASSERT(executor_create(0) == NULL);
+
+	executor = executor_create(NUM_WORKERS);
+	TEST_ASSERT(executor != NULL);
+
+	for (long i = 0; i < NUM_JOBS; i++)
+		futures[i] = executor_submit(executor, square, (void *) i);
+
+	for (long i = 0; i < NUM_JOBS; i++)
+		if (!future_wait(futures[i], &result) && (long) result == i * i)
+			correct++;
+	TEST_ASSERT(correct == NUM_JOBS);
+
+	/* A job blocked on a semaphore does not prevent others to run */
+	blocked = executor_submit(executor, wait_gate, executor);
+	opener = executor_submit(executor, open_gate, NULL);
+
+	TEST_ASSERT(future_wait(opener, NULL) == 0);
+	TEST_ASSERT(future_wait(blocked, &result) == 0);
+	TEST_ASSERT(result == executor);
+
+	TEST_ASSERT(executor_submit(executor, NULL, NULL) == NULL);
+	TEST_ASSERT(executor_destroy(executor) == 0);
+}
+
+static void single_wake(void *arg)
+{
+	executor_t executor;
+	future_t futures[NUM_WORKERS];
+	uintptr_t total_parked = 0;
+	void *result;
+
+	executor = executor_create(NUM_WORKERS);
+
+	/* Let all the workers park */
+	uthread_yield();
+
+	/* Each job wakes the last parked worker up, and only that one */
+	for (int i = 0; i < NUM_JOBS; i++)
+		future_wait(executor_submit(executor, num_parked, NULL), NULL);
+
+	/* Have every worker report how many times it parked */
+	for (int i = 0; i < NUM_WORKERS; i++)
+		futures[i] = executor_submit(executor, wait_gate_num_parked,
+					     NULL);
+	uthread_yield();
+
+	for (int i = 0; i < NUM_WORKERS; i++)
+		sem_up(gate);
+	for (int i = 0; i < NUM_WORKERS; i++) {
+		future_wait(futures[i], &result);
+		total_parked += (uintptr_t) result;
+	}
+	TEST_ASSERT(total_parked == NUM_WORKERS + NUM_JOBS);
+
+	TEST_ASSERT(executor_destroy(executor) == 0);
+}
+
+static void repark(void *arg)
+{
+	executor_t executor;
+	future_t first, second, third;
+	void *first_worker, *second_worker, *third_worker;
+
+	executor = executor_create(2);
+	uthread_yield();
+
+	/* The first job blocks the worker it woke up */
+	first = executor_submit(executor, wait_gate_whoami, NULL);
+	uthread_yield();
+
+	/* The busy worker is made ready before the idle one gets woken up
+	   for the second job, so it runs first and takes that job */
+	sem_up(gate);
+	second = executor_submit(executor, whoami, NULL);
+
+	TEST_ASSERT(future_wait(first, &first_worker) == 0);
+	TEST_ASSERT(future_wait(second, &second_worker) == 0);
+	TEST_ASSERT(first_worker == second_worker);
+
+	/* The worker woken up for nothing parked again, last */
+	third = executor_submit(executor, whoami, NULL);
+	TEST_ASSERT(future_wait(third, &third_worker) == 0);
+	TEST_ASSERT(third_worker != first_worker);
+
+	TEST_ASSERT(executor_destroy(executor) == 0);
+}
+
+static void destroy_parked(void *arg)
+{
+	executor_t executor;
+
+	executor = executor_create(NUM_WORKERS);
+	uthread_yield();
+
+	/* Every parked worker must wake up and exit for this to return */
+	TEST_ASSERT(executor_destroy(executor) == 0);
+	destroyed = 1;
+}
+
+int main(void)
+{
+	gate = sem_create(0);
+
+	fprintf(stderr, "*** TEST executor ***\n");
+	uthread_start(client, NULL);
+
+	fprintf(stderr, "*** TEST executor_single_wake ***\n");
+	uthread_start(single_wake, NULL);
+
+	fprintf(stderr, "*** TEST executor_repark ***\n");
+	uthread_start(repark, NULL);
+
+	fprintf(stderr, "*** TEST executor_destroy_parked ***\n");
+	uthread_start(destroy_parked, NULL);
+	TEST_ASSERT(destroyed);
+
+	sem_destroy(gate);
+
+	return 0;
+}
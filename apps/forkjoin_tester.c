@@ -0,0 +1,157 @@
+/*
+ * Fork/join test
+ *
+ * Runs parallel loops with various grains and checks every index is visited
+ * exactly once, in chunks no larger than the grain. Then computes Fibonacci
+ * numbers with nested spawns, and waits on a scope whose child blocks in
+ * another thread.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <forkjoin.h>
+#include <sem.h>
+#include <uthread.h>
+
+#define RANGE	1000
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+struct loop {
+	size_t grain;
+	size_t next;
+	bool ok;
+	int visits[RANGE];
+};
+
+struct fib {
+	int n;
+	long result;
+};
+
+sem_t gate;
+uthread_join_t shared_join = UTHREAD_JOIN_INIT;
+bool child_started;
+bool child_done;
+
+static void visit(size_t begin, size_t end, void *ctx)
+{
+	struct loop *loop = ctx;
+
+	/* Chunks come in order, and never exceed the grain */
+	if (begin != loop->next || end - begin > loop->grain)
+		loop->ok = false;
+	loop->next = end;
+
+	for (size_t i = begin; i < end; i++)
+		loop->visits[i]++;
+}
+
+static int run_loop(struct loop *loop, size_t grain)
+{
+	loop->grain = grain ? grain : 1;
+	loop->next = 0;
+	loop->ok = true;
+	for (size_t i = 0; i < RANGE; i++)
+		loop->visits[i] = 0;
+
+	if (uthread_parallel_for(0, RANGE, grain, visit, loop))
+		return 0;
+
+	for (size_t i = 0; i < RANGE; i++)
+		if (loop->visits[i] != 1)
+			return 0;
+
+	return loop->ok && loop->next == RANGE;
+}
+
+static void fib(void *arg)
+{
+	struct fib *f = arg;
+	struct fib x = { f->n - 1, 0 };
+	struct fib y = { f->n - 2, 0 };
+	uthread_join_t join = UTHREAD_JOIN_INIT;
+
+	if (f->n < 2) {
+		f->result = f->n;
+		return;
+	}
+
+	uthread_spawn(&join, fib, &x);
+	uthread_spawn(&join, fib, &y);
+	uthread_sync(&join);
+
+	f->result = x.result + y.result;
+}
+
+static void wait_gate(void *arg)
+{
+	child_started = true;
+	sem_down(gate);
+	child_done = true;
+}
+
+static void spawner(void *arg)
+{
+	uthread_spawn(&shared_join, wait_gate, NULL);
+}
+
+static void opener(void *arg)
+{
+	sem_up(gate);
+}
+
+static void client(void *arg)
+{
+	static struct loop loop;
+	struct fib f = { 20, 0 };
+	uthread_join_t join = UTHREAD_JOIN_INIT;
+
+	TEST_ASSERT(run_loop(&loop, 1));
+	TEST_ASSERT(run_loop(&loop, 7));
+	TEST_ASSERT(run_loop(&loop, 64));
+	TEST_ASSERT(run_loop(&loop, RANGE * 2));
+	TEST_ASSERT(run_loop(&loop, 0));
+
+	TEST_ASSERT(uthread_parallel_for(5, 5, 1, visit, &loop) == 0);
+	TEST_ASSERT(uthread_parallel_for(5, 4, 1, visit, &loop) == -1);
+	TEST_ASSERT(uthread_parallel_for(0, 1, 1, NULL, NULL) == -1);
+
+	fib(&f);
+	TEST_ASSERT(f.result == 6765);
+
+	TEST_ASSERT(uthread_spawn(NULL, fib, &f) == -1);
+	TEST_ASSERT(uthread_spawn(&join, NULL, NULL) == -1);
+	TEST_ASSERT(uthread_sync(&join) == 0);
+
+	/* The child spawned by another thread blocks, sync waits for it */
+	uthread_create(spawner, NULL);
+	uthread_create(opener, NULL);
+	while (!child_started)
+		uthread_yield();
+
+	TEST_ASSERT(uthread_sync(&shared_join) == 0);
+	TEST_ASSERT(child_done);
+}
+
+int main(void)
+{
+	gate = sem_create(0);
+
+	uthread_start(client, NULL);
+
+	sem_destroy(gate);
+
+	return 0;
+}
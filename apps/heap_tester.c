@@ -0,0 +1,172 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+#define TEST_ASSERT(assert)                \
+do {                                    \
+    printf("ASSERT: " #assert " ... ");    \
+    if (assert) {                        \
+        printf("PASS\n");                \
+    } else    {                            \
+        printf("FAIL\n");                \
+        exit(1);                        \
+    }                                    \
+} while(0)
+
+#define NUM_ITEMS 1000
+
+int data[NUM_ITEMS];
+heap_t h;
+
+/* Create */
+void test_create(void)
+{
+    fprintf(stderr, "*** TEST create ***\n");
+
+    h = heap_create();
+    TEST_ASSERT(h != NULL);
+    TEST_ASSERT(heap_length(h) == 0);
+}
+
+/* Push/Pop simple */
+void test_heap_simple(void)
+{
+    int *ptr;
+    uint64_t key;
+    fprintf(stderr, "*** TEST heap_simple ***\n");
+
+    heap_push(h, 7, &data[0]);
+    TEST_ASSERT(heap_peek_key(h, &key) == 0 && key == 7);
+    TEST_ASSERT(heap_pop(h, (void**)&ptr) == 0);
+    TEST_ASSERT(ptr == &data[0]);
+    TEST_ASSERT(heap_pop(h, (void**)&ptr) == -1);
+    TEST_ASSERT(heap_peek_key(h, &key) == -1);
+}
+
+/* Pop by increasing key, whatever the push order */
+void test_heap_order(void)
+{
+    int *ptr;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST heap_order ***\n");
+
+    /* Keys are a permutation of [0, NUM_ITEMS) */
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        int key = (i * 397) % NUM_ITEMS;
+
+        data[key] = key;
+        heap_push(h, key, &data[key]);
+    }
+    TEST_ASSERT(heap_length(h) == NUM_ITEMS);
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        heap_pop(h, (void**)&ptr);
+        if(*ptr != i)
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(heap_length(h) == 0);
+}
+
+/* Equal keys pop in push order */
+void test_heap_ties(void)
+{
+    int *ptr;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST heap_ties ***\n");
+
+    for(int i = 0; i < 100; i++) {
+        heap_push(h, i % 2 ? 5 : 9, &data[i]);
+    }
+
+    for(int i = 1; i < 100; i += 2) {
+        heap_pop(h, (void**)&ptr);
+        if(ptr != &data[i])
+            ordered = 0;
+    }
+    for(int i = 0; i < 100; i += 2) {
+        heap_pop(h, (void**)&ptr);
+        if(ptr != &data[i])
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+}
+
+/* Remove items from anywhere, the others still popping in order */
+void test_heap_remove(void)
+{
+    int *ptr;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST heap_remove ***\n");
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        int key = (i * 397) % NUM_ITEMS;
+
+        data[key] = key;
+        heap_push(h, key, &data[key]);
+    }
+
+    /* Remove every third item, including the root and the last one */
+    for(int i = 0; i < NUM_ITEMS; i += 3) {
+        if(heap_remove(h, &data[i]))
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(heap_remove(h, &data[0]) == -1);
+    TEST_ASSERT(heap_length(h) == NUM_ITEMS - (NUM_ITEMS + 2) / 3);
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        if(i % 3 == 0)
+            continue;
+        heap_pop(h, (void**)&ptr);
+        if(*ptr != i)
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(heap_length(h) == 0);
+}
+
+/* Errors */
+void test_heap_errors(void)
+{
+    int *ptr;
+    uint64_t key;
+    fprintf(stderr, "*** TEST heap_errors ***\n");
+
+    TEST_ASSERT(heap_reserve(h, NUM_ITEMS) == 0);
+    TEST_ASSERT(heap_push(NULL, 0, &data[0]) == -1);
+    TEST_ASSERT(heap_push(h, 0, NULL) == -1);
+    TEST_ASSERT(heap_pop(NULL, (void**)&ptr) == -1);
+    TEST_ASSERT(heap_pop(h, NULL) == -1);
+    TEST_ASSERT(heap_peek_key(h, NULL) == -1);
+    TEST_ASSERT(heap_peek_key(NULL, &key) == -1);
+    TEST_ASSERT(heap_remove(NULL, &data[0]) == -1);
+    TEST_ASSERT(heap_remove(h, NULL) == -1);
+    TEST_ASSERT(heap_length(NULL) == 0);
+}
+
+/* Destroy */
+void test_heap_destroy(void)
+{
+    fprintf(stderr, "*** TEST heap_destroy ***\n");
+
+    heap_push(h, 1, &data[0]);
+    TEST_ASSERT(heap_destroy(h) == 0);
+    TEST_ASSERT(heap_destroy(NULL) == -1);
+}
+
+int main(void)
+{
+    test_create();
+    test_heap_simple();
+    test_heap_order();
+    test_heap_ties();
+    test_heap_remove();
+    test_heap_errors();
+    test_heap_destroy();
+
+    return 0;
+}
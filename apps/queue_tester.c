@@ -97,6 +97,77 @@ void test_queue_iterate(void) {
     TEST_ASSERT(queue_length(q) == 4);
 }
 
+/* Enqueue with handles, remove by handle */
+void test_queue_handle(void) {
+    int data3[] = {1, 2, 3, 4};
+    queue_handle_t handles[4];
+    int *ptr;
+    fprintf(stderr, "*** TEST queue_handle ***\n");
+
+    queue_t q3 = queue_create();
+
+    for(int i = 0; i < 4; i++) {
+        handles[i] = queue_enqueue_handle(q3, &data3[i]);
+    }
+    TEST_ASSERT(handles[0] != NULL && handles[3] != NULL);
+    TEST_ASSERT(queue_enqueue_handle(q3, NULL) == NULL);
+
+    /* Middle, back, then front */
+    TEST_ASSERT(queue_remove_handle(q3, handles[2]) == 0);
+    TEST_ASSERT(queue_remove_handle(q3, handles[3]) == 0);
+    TEST_ASSERT(queue_remove_handle(q3, handles[0]) == 0);
+    TEST_ASSERT(queue_length(q3) == 1);
+    TEST_ASSERT(queue_remove_handle(q3, NULL) == -1);
+
+    /* The back must follow the removal of the last item */
+    queue_enqueue(q3, &data3[3]);
+    queue_dequeue(q3, (void**)&ptr);
+    TEST_ASSERT(ptr == &data3[1]);
+    queue_dequeue(q3, (void**)&ptr);
+    TEST_ASSERT(ptr == &data3[3]);
+    TEST_ASSERT(queue_length(q3) == 0);
+
+    TEST_ASSERT(queue_destroy(q3) == 0);
+}
+
+/* Batch enqueue, splice and drain */
+void test_queue_bulk(void) {
+    int data4[] = {1, 2, 3, 4, 5, 6};
+    void *items[] = {&data4[0], &data4[1], &data4[2],
+                     &data4[3], &data4[4], &data4[5]};
+    void *bad_items[] = {&data4[0], NULL};
+    void *out[6];
+    fprintf(stderr, "*** TEST queue_bulk ***\n");
+
+    queue_t q4 = queue_create();
+    queue_t q5 = queue_create();
+
+    TEST_ASSERT(queue_enqueue_batch(q4, items, 3) == 0);
+    TEST_ASSERT(queue_enqueue_batch(q5, items + 3, 3) == 0);
+    TEST_ASSERT(queue_enqueue_batch(q5, bad_items, 2) == -1);
+    TEST_ASSERT(queue_length(q5) == 3);
+
+    TEST_ASSERT(queue_splice(q4, q5) == 0);
+    TEST_ASSERT(queue_length(q4) == 6);
+    TEST_ASSERT(queue_length(q5) == 0);
+    TEST_ASSERT(queue_splice(q4, q4) == -1);
+
+    TEST_ASSERT(queue_drain(q4, out, 4) == 4);
+    TEST_ASSERT(out[0] == &data4[0] && out[3] == &data4[3]);
+    TEST_ASSERT(queue_drain(q4, out, 6) == 2);
+    TEST_ASSERT(out[0] == &data4[4] && out[1] == &data4[5]);
+    TEST_ASSERT(queue_drain(q4, out, 6) == 0);
+
+    /* Splice into an empty queue */
+    queue_enqueue_batch(q5, items, 2);
+    TEST_ASSERT(queue_splice(q4, q5) == 0);
+    TEST_ASSERT(queue_drain(q4, out, 6) == 2);
+    TEST_ASSERT(out[0] == &data4[0] && out[1] == &data4[1]);
+
+    queue_destroy(q4);
+    queue_destroy(q5);
+}
+
 /* Destroy */
 void test_queue_destroy(void) {
     int data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
@@ -120,6 +191,8 @@ int main(void)
     test_queue_dequeue_multiple();
     test_queue_delete();
     test_queue_iterate();
+    test_queue_handle();
+    test_queue_bulk();
     test_queue_destroy();
 
     return 0;
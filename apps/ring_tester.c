@@ -0,0 +1,204 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ring.h"
+
+#define TEST_ASSERT(assert)                \
+do {                                    \
+    printf("ASSERT: " #assert " ... ");    \
+    if (assert) {                        \
+        printf("PASS\n");                \
+    } else    {                            \
+        printf("FAIL\n");                \
+        exit(1);                        \
+    }                                    \
+} while(0)
+
+#define NUM_ITEMS 1000
+
+int data[NUM_ITEMS];
+ring_t r;
+
+/* Create */
+void test_create(void)
+{
+    fprintf(stderr, "*** TEST create ***\n");
+
+    r = ring_create();
+    TEST_ASSERT(r != NULL);
+    TEST_ASSERT(ring_length(r) == 0);
+}
+
+/* Push/Pop simple */
+void test_ring_simple(void)
+{
+    int *ptr;
+    fprintf(stderr, "*** TEST ring_simple ***\n");
+
+    ring_push(r, &data[0]);
+    TEST_ASSERT(ring_length(r) == 1);
+    TEST_ASSERT(ring_pop(r, (void**)&ptr) == 0);
+    TEST_ASSERT(ptr == &data[0]);
+    TEST_ASSERT(ring_pop(r, (void**)&ptr) == -1);
+}
+
+/* Grow past the initial capacity while the items wrap around */
+void test_ring_grow_wrapped(void)
+{
+    int *ptr;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST ring_grow_wrapped ***\n");
+
+    /* Move the front of the ring to its middle */
+    for(int i = 0; i < 10; i++) {
+        ring_push(r, &data[i]);
+    }
+    for(int i = 0; i < 10; i++) {
+        ring_pop(r, (void**)&ptr);
+    }
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        ring_push(r, &data[i]);
+    }
+    TEST_ASSERT(ring_length(r) == NUM_ITEMS);
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        ring_pop(r, (void**)&ptr);
+        if(ptr != &data[i])
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(ring_length(r) == 0);
+}
+
+/* Reserve, then push and pop in turns, like the ready queue */
+void test_ring_reserve(void)
+{
+    int *ptr;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST ring_reserve ***\n");
+
+    TEST_ASSERT(ring_reserve(r, NUM_ITEMS) == 0);
+
+    for(int i = 0; i < 3; i++) {
+        ring_push(r, &data[i]);
+    }
+    for(int i = 3; i < NUM_ITEMS; i++) {
+        ring_pop(r, (void**)&ptr);
+        if(ptr != &data[i - 3])
+            ordered = 0;
+        ring_push(r, &data[i]);
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(ring_length(r) == 3);
+}
+
+/* Reach and replace items in place through their tickets */
+void test_ring_slot(void)
+{
+    int *ptr;
+    size_t tickets[5];
+    fprintf(stderr, "*** TEST ring_slot ***\n");
+
+    /* Empty the ring left by the previous test */
+    while(ring_pop(r, (void**)&ptr) == 0)
+        ;
+
+    for(int i = 0; i < 5; i++) {
+        tickets[i] = ring_next_ticket(r);
+        ring_push(r, &data[i]);
+    }
+    TEST_ASSERT(tickets[4] == tickets[0] + 4);
+    TEST_ASSERT(*ring_slot(r, tickets[2]) == &data[2]);
+
+    /* The new item takes over the place of the old one */
+    *ring_slot(r, tickets[2]) = &data[10];
+    ring_pop(r, (void**)&ptr);
+    TEST_ASSERT(ptr == &data[0]);
+    TEST_ASSERT(ring_slot(r, tickets[0]) == NULL);
+    TEST_ASSERT(ring_slot(r, ring_next_ticket(r)) == NULL);
+
+    /* Tickets survive growing the ring */
+    TEST_ASSERT(ring_reserve(r, NUM_ITEMS) == 0);
+    TEST_ASSERT(*ring_slot(r, tickets[4]) == &data[4]);
+
+    ring_pop(r, (void**)&ptr);
+    ring_pop(r, (void**)&ptr);
+    TEST_ASSERT(ptr == &data[10]);
+    TEST_ASSERT(ring_slot(NULL, 0) == NULL);
+}
+
+/* Push a batch wrapping around the end of the array, then one growing it */
+void test_ring_push_batch(void)
+{
+    int *ptr;
+    void *items[NUM_ITEMS];
+    int ordered = 1;
+    ring_t batch = ring_create();
+    fprintf(stderr, "*** TEST ring_push_batch ***\n");
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        items[i] = &data[i];
+    }
+
+    /* Move the front of a new ring close to the end of its array */
+    for(int i = 0; i < 10; i++) {
+        ring_push(batch, &data[i]);
+        ring_pop(batch, (void**)&ptr);
+    }
+
+    TEST_ASSERT(ring_push_batch(batch, items, 10) == 0);
+    TEST_ASSERT(ring_push_batch(batch, items + 10, NUM_ITEMS - 10) == 0);
+    TEST_ASSERT(ring_push_batch(batch, items, 0) == 0);
+    TEST_ASSERT(ring_length(batch) == NUM_ITEMS);
+
+    for(int i = 0; i < NUM_ITEMS; i++) {
+        ring_pop(batch, (void**)&ptr);
+        if(ptr != &data[i])
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(ring_length(batch) == 0);
+
+    TEST_ASSERT(ring_push_batch(NULL, items, 1) == -1);
+    TEST_ASSERT(ring_push_batch(batch, NULL, 1) == -1);
+    ring_destroy(batch);
+}
+
+/* Errors */
+void test_ring_errors(void)
+{
+    int *ptr;
+    fprintf(stderr, "*** TEST ring_errors ***\n");
+
+    TEST_ASSERT(ring_push(NULL, &data[0]) == -1);
+    TEST_ASSERT(ring_push(r, NULL) == -1);
+    TEST_ASSERT(ring_pop(NULL, (void**)&ptr) == -1);
+    TEST_ASSERT(ring_pop(r, NULL) == -1);
+    TEST_ASSERT(ring_reserve(NULL, 1) == -1);
+    TEST_ASSERT(ring_length(NULL) == 0);
+}
+
+/* Destroy */
+void test_ring_destroy(void)
+{
+    fprintf(stderr, "*** TEST ring_destroy ***\n");
+
+    TEST_ASSERT(ring_destroy(r) == 0);
+    TEST_ASSERT(ring_destroy(NULL) == -1);
+}
+
+int main(void)
+{
+    test_create();
+    test_ring_simple();
+    test_ring_grow_wrapped();
+    test_ring_reserve();
+    test_ring_slot();
+    test_ring_push_batch();
+    test_ring_errors();
+    test_ring_destroy();
+
+    return 0;
+}
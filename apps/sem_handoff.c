@@ -0,0 +1,101 @@
+/*
+ * Semaphore handoff test
+ *
+ * Checks sem_up() hands the resource directly to the oldest blocked thread:
+ * the releasing thread cannot take it back before the woken thread ran, the
+ * semaphore can be destroyed before the woken thread ran, and the wait of the
+ * woken thread is still accounted for in the statistics.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+sem_t sem;
+int order[2];
+int num_acquired;
+
+static void waiter(void *arg)
+{
+	sem_down(sem);
+	order[num_acquired++] = 2;
+	sem_up(sem);
+}
+
+static void holder(void *arg)
+{
+	sem_down(sem);
+	uthread_create(waiter, NULL);
+
+	/* Let the waiter block */
+	uthread_yield();
+
+	/* The resource goes to the waiter, which gets it first */
+	sem_up(sem);
+	sem_down(sem);
+	order[num_acquired++] = 1;
+	sem_up(sem);
+
+	TEST_ASSERT(num_acquired == 2);
+	TEST_ASSERT(order[0] == 2 && order[1] == 1);
+}
+
+static void destroyer(void *arg)
+{
+	sem_down(sem);
+	uthread_create(waiter, NULL);
+	uthread_yield();
+
+	/* The waiter does not touch the semaphore once woken up */
+	sem_up(sem);
+	TEST_ASSERT(sem_destroy(sem) == 0);
+	sem = NULL;
+}
+
+static void releaser(void *arg)
+{
+	sem_down(sem);
+	uthread_create(waiter, NULL);
+	uthread_yield();
+	sem_up(sem);
+}
+
+int main(void)
+{
+	struct sem_stats stats;
+
+	fprintf(stderr, "*** TEST sem_handoff_no_barging ***\n");
+	sem = sem_create(1);
+	uthread_start(holder, NULL);
+	TEST_ASSERT(sem_destroy(sem) == 0);
+
+	fprintf(stderr, "*** TEST sem_handoff_destroy ***\n");
+	num_acquired = 0;
+	sem = sem_create(1);
+	uthread_start(destroyer, NULL);
+	TEST_ASSERT(num_acquired == 1);
+
+	fprintf(stderr, "*** TEST sem_handoff_stats ***\n");
+	num_acquired = 0;
+	sem = sem_create_named(1, "handoff");
+	uthread_start(releaser, NULL);
+	TEST_ASSERT(sem_stats(sem, &stats) == 0);
+	TEST_ASSERT(stats.acquires == 2);
+	TEST_ASSERT(stats.contended == 1);
+	TEST_ASSERT(sem_destroy(sem) == 0);
+
+	return 0;
+}
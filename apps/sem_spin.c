@@ -0,0 +1,107 @@
+/*
+ * Adaptive semaphore test
+ *
+ * Checks a waiter yields rather than blocks while the holder of a spinning
+ * semaphore can still run, and gets the semaphore without ever blocking. Then
+ * checks a waiter blocks right away once the holder is itself blocked, and
+ * that a semaphore cannot be destroyed while a thread yields for it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+sem_t lock;
+sem_t gate;
+int num_acquired;
+
+static void waiter(void *arg)
+{
+	sem_down(lock);
+	num_acquired++;
+	sem_up(lock);
+}
+
+static void holder(void *arg)
+{
+	struct sem_stats stats;
+
+	sem_down(lock);
+	uthread_create(waiter, NULL);
+
+	/* Let the waiter start yielding for the lock */
+	uthread_yield();
+	uthread_yield();
+	TEST_ASSERT(sem_destroy(lock) == -1);
+	TEST_ASSERT(num_acquired == 0);
+
+	sem_up(lock);
+	uthread_yield();
+	uthread_yield();
+	TEST_ASSERT(num_acquired == 1);
+
+	sem_stats(lock, &stats);
+	TEST_ASSERT(stats.spun == 1);
+	TEST_ASSERT(stats.contended == 0);
+}
+
+static void blocked_holder(void *arg)
+{
+	struct sem_stats stats;
+
+	sem_down(lock);
+	uthread_create(waiter, NULL);
+
+	/* The waiter cannot hope for the lock while we are blocked */
+	sem_down(gate);
+	sem_up(lock);
+	uthread_yield();
+	TEST_ASSERT(num_acquired == 1);
+
+	sem_stats(lock, &stats);
+	TEST_ASSERT(stats.spun == 0);
+	TEST_ASSERT(stats.contended == 1);
+}
+
+static void opener(void *arg)
+{
+	uthread_create(blocked_holder, NULL);
+	uthread_yield();
+	uthread_yield();
+	sem_up(gate);
+}
+
+int main(void)
+{
+	TEST_ASSERT(sem_set_spin(NULL, 1) == -1);
+
+	fprintf(stderr, "*** TEST sem_spin ***\n");
+	lock = sem_create_named(1, "lock");
+	TEST_ASSERT(sem_set_spin(lock, 16) == 0);
+	uthread_start(holder, NULL);
+	TEST_ASSERT(sem_destroy(lock) == 0);
+
+	fprintf(stderr, "*** TEST sem_spin_blocked_holder ***\n");
+	num_acquired = 0;
+	lock = sem_create_named(1, "lock");
+	gate = sem_create(0);
+	sem_set_spin(lock, 16);
+	uthread_start(opener, NULL);
+	TEST_ASSERT(sem_destroy(lock) == 0);
+	TEST_ASSERT(sem_destroy(gate) == 0);
+
+	return 0;
+}
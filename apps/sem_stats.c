@@ -0,0 +1,78 @@
+/*
+ * Semaphore statistics test
+ *
+ * Several threads take turns on a "hot" semaphore, each yielding while holding
+ * it so that the others contend for it, while a "cold" semaphore is taken
+ * without contention. The dump should rank the hot semaphore first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_THREADS	4
+#define NUM_ROUNDS	5
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+sem_t hot;
+sem_t cold;
+
+static void worker(void *arg)
+{
+	for (int i = 0; i < NUM_ROUNDS; i++) {
+		sem_down(hot);
+		uthread_yield();
+		sem_up(hot);
+		uthread_yield();
+	}
+
+	sem_down(cold);
+	sem_up(cold);
+}
+
+static void spawner(void *arg)
+{
+	for (int i = 0; i < NUM_THREADS; i++)
+		uthread_create(worker, NULL);
+}
+
+int main(void)
+{
+	struct sem_stats stats;
+
+	hot = sem_create_named(1, "hot");
+	cold = sem_create_named(1, NULL);
+
+	uthread_start(spawner, NULL);
+
+	TEST_ASSERT(sem_stats(hot, &stats) == 0);
+	TEST_ASSERT(stats.acquires == NUM_THREADS * NUM_ROUNDS);
+	TEST_ASSERT(stats.contended > 0);
+	TEST_ASSERT(stats.max_queue_depth > 0);
+	TEST_ASSERT(stats.max_queue_depth <= NUM_THREADS - 1);
+
+	TEST_ASSERT(sem_stats(cold, &stats) == 0);
+	TEST_ASSERT(stats.acquires == NUM_THREADS);
+	TEST_ASSERT(stats.contended == 0);
+
+	TEST_ASSERT(sem_stats_dump(stdout, 1) == 1);
+	TEST_ASSERT(sem_stats_dump(stdout, 10) == 2);
+
+	TEST_ASSERT(sem_destroy(cold) == 0);
+	TEST_ASSERT(sem_stats_dump(stdout, 10) == 1);
+	TEST_ASSERT(sem_destroy(hot) == 0);
+
+	return 0;
+}
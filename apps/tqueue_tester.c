@@ -0,0 +1,169 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tqueue.h"
+
+#define TEST_ASSERT(assert)                \
+do {                                    \
+    printf("ASSERT: " #assert " ... ");    \
+    if (assert) {                        \
+        printf("PASS\n");                \
+    } else    {                            \
+        printf("FAIL\n");                \
+        exit(1);                        \
+    }                                    \
+} while(0)
+
+struct item {
+    int value;
+    struct item *link;
+};
+
+QUEUE_DEFINE(item_queue, struct item, link)
+
+struct item items[10];
+struct item_queue q = QUEUE_INIT;
+
+/* Create */
+void test_create(void)
+{
+    fprintf(stderr, "*** TEST create ***\n");
+
+    for(int i = 0; i < 10; i++) {
+        items[i].value = i + 1;
+    }
+
+    TEST_ASSERT(item_queue_empty(&q));
+    TEST_ASSERT(item_queue_length(&q) == 0);
+    TEST_ASSERT(item_queue_dequeue(&q) == NULL);
+}
+
+/* Enqueue/Dequeue simple */
+void test_queue_simple(void)
+{
+    fprintf(stderr, "*** TEST queue_simple ***\n");
+
+    item_queue_enqueue(&q, &items[0]);
+    TEST_ASSERT(item_queue_peek(&q) == &items[0]);
+    TEST_ASSERT(item_queue_dequeue(&q) == &items[0]);
+    TEST_ASSERT(item_queue_empty(&q));
+}
+
+/* Enqueue/Dequeue Multiple */
+void test_queue_dequeue_multiple(void)
+{
+    fprintf(stderr, "*** TEST queue_dequeue_multiple ***\n");
+
+    for(int i = 0; i < 10; i++) {
+        item_queue_enqueue(&q, &items[i]);
+    }
+    TEST_ASSERT(item_queue_length(&q) == 10);
+
+    TEST_ASSERT(item_queue_dequeue(&q) == &items[0]);
+    TEST_ASSERT(item_queue_dequeue(&q) == &items[1]);
+    TEST_ASSERT(item_queue_dequeue(&q) == &items[2]);
+    TEST_ASSERT(item_queue_length(&q) == 7);
+}
+
+/* Remove from the middle, the back and the front */
+void test_queue_remove(void)
+{
+    fprintf(stderr, "*** TEST queue_remove ***\n");
+
+    TEST_ASSERT(item_queue_remove(&q, &items[5]) == 0);
+    TEST_ASSERT(item_queue_remove(&q, &items[9]) == 0);
+    TEST_ASSERT(item_queue_remove(&q, &items[3]) == 0);
+    TEST_ASSERT(item_queue_remove(&q, &items[0]) == -1);
+    TEST_ASSERT(item_queue_length(&q) == 4);
+
+    /* The tail must follow the removal of the last item */
+    item_queue_enqueue(&q, &items[9]);
+    TEST_ASSERT(item_queue_length(&q) == 5);
+}
+
+/* Foreach */
+void test_queue_foreach(void)
+{
+    struct item *item;
+    int expected[] = {5, 7, 8, 9, 10};
+    int i = 0;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST queue_foreach ***\n");
+
+    QUEUE_FOREACH(item, &q, link) {
+        if(item->value != expected[i++])
+            ordered = 0;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(i == 5);
+}
+
+/* Splice */
+void test_queue_splice(void)
+{
+    struct item_queue other = QUEUE_INIT;
+    fprintf(stderr, "*** TEST queue_splice ***\n");
+
+    item_queue_enqueue(&other, &items[0]);
+    item_queue_enqueue(&other, &items[1]);
+    item_queue_splice(&q, &other);
+
+    TEST_ASSERT(item_queue_empty(&other));
+    TEST_ASSERT(item_queue_length(&q) == 7);
+
+    /* The back of the queue must be the back of other */
+    item_queue_enqueue(&q, &items[2]);
+    TEST_ASSERT(item_queue_remove(&q, &items[2]) == 0);
+    TEST_ASSERT(item_queue_remove(&q, &items[1]) == 0);
+    TEST_ASSERT(item_queue_length(&q) == 6);
+
+    /* Splice into an empty queue */
+    item_queue_splice(&other, &q);
+    TEST_ASSERT(item_queue_peek(&other) == &items[4]);
+    item_queue_splice(&q, &other);
+}
+
+/* Drain */
+void test_queue_drain(void)
+{
+    struct item *item;
+    int expected[] = {5, 7, 8, 9, 10, 1};
+    int i = 0;
+    int ordered = 1;
+    fprintf(stderr, "*** TEST queue_drain ***\n");
+
+    item = item_queue_drain(&q);
+    TEST_ASSERT(item_queue_empty(&q));
+    TEST_ASSERT(item_queue_length(&q) == 0);
+
+    /* The drained items stay chained, from the oldest one */
+    for(; item != NULL; item = item->link) {
+        if(i == 6 || item->value != expected[i])
+            ordered = 0;
+        i++;
+    }
+    TEST_ASSERT(ordered);
+    TEST_ASSERT(i == 6);
+
+    TEST_ASSERT(item_queue_drain(&q) == NULL);
+
+    /* The queue is usable again */
+    item_queue_enqueue(&q, &items[1]);
+    TEST_ASSERT(item_queue_peek(&q) == &items[1]);
+    TEST_ASSERT(item_queue_dequeue(&q) == &items[1]);
+    TEST_ASSERT(item_queue_empty(&q));
+}
+
+int main(void)
+{
+    test_create();
+    test_queue_simple();
+    test_queue_dequeue_multiple();
+    test_queue_remove();
+    test_queue_foreach();
+    test_queue_splice();
+    test_queue_drain();
+
+    return 0;
+}
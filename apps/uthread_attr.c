@@ -0,0 +1,79 @@
+/*
+ * Thread attributes test
+ *
+ * Creates a thread with a small stack and a name, and a thread with a large
+ * stack which recurses deeper than the default stack size would allow.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <uthread.h>
+
+#define BIG_STACK_SIZE	(1024 * 1024)
+#define FRAME_SIZE	1024
+#define RECURSION_DEPTH	256
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int depth_reached;
+
+static int recurse(int depth)
+{
+	volatile char frame[FRAME_SIZE];
+
+	frame[0] = 1;
+	if (depth == RECURSION_DEPTH)
+		return depth;
+
+	return recurse(depth + 1) + frame[0] - 1;
+}
+
+static void deep(void *arg)
+{
+	depth_reached = recurse(0);
+}
+
+static void tiny(void *arg)
+{
+	TEST_ASSERT(uthread_name() != NULL);
+	TEST_ASSERT(strcmp(uthread_name(), "tiny-worker-nam") == 0);
+}
+
+static void spawner(void *arg)
+{
+	uthread_attr_t attr;
+
+	TEST_ASSERT(uthread_name() == NULL);
+
+	uthread_attr_init(&attr);
+	attr.stack_size = UTHREAD_STACK_MIN;
+	attr.name = "tiny-worker-name-too-long";
+	TEST_ASSERT(uthread_create_attr(&attr, tiny, NULL) == 0);
+
+	uthread_attr_init(&attr);
+	attr.stack_size = BIG_STACK_SIZE;
+	TEST_ASSERT(uthread_create_attr(&attr, deep, NULL) == 0);
+
+	attr.stack_size = UTHREAD_STACK_MIN - 1;
+	TEST_ASSERT(uthread_create_attr(&attr, deep, NULL) == -1);
+}
+
+int main(void)
+{
+	uthread_start(spawner, NULL);
+
+	TEST_ASSERT(depth_reached == RECURSION_DEPTH);
+
+	return 0;
+}
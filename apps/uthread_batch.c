@@ -0,0 +1,124 @@
+/*
+ * Batch creation test
+ *
+ * Creates batches of threads and checks they all run, in order, with their
+ * own argument, and that invalid batches, including one too large for its
+ * stacks to be allocated at all, create no thread. Then creates a batch under
+ * a policy which enqueues the threads one by one.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define BATCH	100
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+long order[BATCH];
+size_t num_ran;
+int null_args;
+
+static void record(void *arg)
+{
+	order[num_ran++] = (long) arg;
+}
+
+static void check_null(void *arg)
+{
+	if (arg == NULL)
+		null_args++;
+}
+
+static void client(void *arg)
+{
+	uthread_func_t funcs[BATCH];
+	void *args[BATCH];
+	uthread_t handles[BATCH];
+	int in_order = 1, distinct = 1;
+
+	for (long i = 0; i < BATCH; i++) {
+		funcs[i] = record;
+		args[i] = (void *) i;
+	}
+
+	TEST_ASSERT(uthread_create_batch(BATCH, funcs, args, handles) == 0);
+	while (num_ran < BATCH)
+		uthread_yield();
+
+	for (long i = 0; i < BATCH; i++)
+		if (order[i] != i)
+			in_order = 0;
+	TEST_ASSERT(in_order);
+
+	for (long i = 1; i < BATCH; i++)
+		if (handles[i] == handles[i - 1])
+			distinct = 0;
+	TEST_ASSERT(distinct);
+
+	/* A batch whose stacks were all released can be created again */
+	for (long i = 0; i < 10; i++)
+		funcs[i] = check_null;
+	TEST_ASSERT(uthread_create_batch(10, funcs, NULL, NULL) == 0);
+	while (null_args < 10)
+		uthread_yield();
+	TEST_ASSERT(null_args == 10);
+
+	/* Invalid batches create nothing */
+	num_ran = 0;
+	funcs[0] = record;
+	funcs[1] = NULL;
+	TEST_ASSERT(uthread_create_batch(2, funcs, args, NULL) == -1);
+	TEST_ASSERT(uthread_create_batch(0, funcs, args, NULL) == -1);
+	TEST_ASSERT(uthread_create_batch(1, NULL, args, NULL) == -1);
+
+	/* So do batches whose stacks do not fit in the address space */
+	TEST_ASSERT(uthread_create_batch(SIZE_MAX / UTHREAD_STACK_SIZE + 1,
+					 funcs, args, NULL) == -1);
+	uthread_yield();
+	TEST_ASSERT(num_ran == 0);
+}
+
+static void fair_client(void *arg)
+{
+	uthread_func_t funcs[BATCH];
+
+	for (long i = 0; i < BATCH; i++)
+		funcs[i] = check_null;
+
+	/* The policy has no batch operation, the threads are enqueued one by
+	   one */
+	TEST_ASSERT(uthread_create_batch(BATCH, funcs, NULL, NULL) == 0);
+	while (null_args < BATCH)
+		uthread_yield();
+	TEST_ASSERT(null_args == BATCH);
+}
+
+int main(void)
+{
+	uthread_opts_t opts;
+	int ret;
+
+	fprintf(stderr, "*** TEST batch ***\n");
+	uthread_start(client, NULL);
+
+	fprintf(stderr, "*** TEST batch_fair ***\n");
+	null_args = 0;
+	uthread_opts_init(&opts);
+	opts.policy = UTHREAD_SCHED_FAIR;
+	ret = uthread_start_opts(&opts, fair_client, NULL);
+	TEST_ASSERT(ret == 0);
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Earliest-deadline-first scheduling test
+ *
+ * Creates threads of various deadlines while the creating thread has the most
+ * urgent one, and checks they run by increasing deadline once it gives up its
+ * deadline. Then checks a thread woken up by a thread without deadline runs
+ * before the waker gets to go on, and that threads without a deadline still
+ * run in turns. Last, checks the FIFO policy ignores deadlines.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+#define MS 1000000ULL
+
+int order[8];
+int num_run;
+
+static void record(void *arg)
+{
+	order[num_run++] = (int) (long) arg;
+}
+
+static void create_with_deadline(long id, uint64_t deadline_ns)
+{
+	uthread_attr_t attr;
+
+	uthread_attr_init(&attr);
+	attr.deadline_ns = deadline_ns;
+	uthread_create_attr(&attr, record, (void*) id);
+}
+
+static void creator(void *arg)
+{
+	/* More urgent than anything created below */
+	uthread_set_deadline(1);
+
+	create_with_deadline(3, 30 * MS);
+	create_with_deadline(1, 10 * MS);
+	create_with_deadline(4, 0);
+	create_with_deadline(2, 20 * MS);
+	create_with_deadline(5, 0);
+
+	/* Nothing may have run before we give way */
+	TEST_ASSERT(num_run == 0);
+	uthread_set_deadline(0);
+}
+
+sem_t wake_sem;
+int woken;
+
+static void sleeper(void *arg)
+{
+	uthread_set_deadline(5 * MS);
+	sem_down(wake_sem);
+	woken = 1;
+}
+
+static void waker(void *arg)
+{
+	uthread_create(sleeper, NULL);
+
+	/* Let the sleeper block, it is the only other thread */
+	uthread_yield();
+	TEST_ASSERT(!woken);
+
+	/* The sleeper preempts us as soon as it is woken up */
+	sem_up(wake_sem);
+	TEST_ASSERT(woken);
+}
+
+int main(void)
+{
+	uthread_opts_t opts;
+
+	uthread_opts_init(&opts);
+	opts.policy = UTHREAD_SCHED_EDF;
+
+	fprintf(stderr, "*** TEST edf_order ***\n");
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_run == 5);
+	TEST_ASSERT(order[0] == 1 && order[1] == 2 && order[2] == 3);
+	TEST_ASSERT(order[3] == 4 && order[4] == 5);
+
+	fprintf(stderr, "*** TEST edf_wakeup ***\n");
+	wake_sem = sem_create(0);
+	uthread_start_opts(&opts, waker, NULL);
+	sem_destroy(wake_sem);
+
+	fprintf(stderr, "*** TEST fifo_ignores_deadlines ***\n");
+	num_run = 0;
+	opts.policy = UTHREAD_SCHED_FIFO;
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_run == 5);
+	TEST_ASSERT(order[0] == 3 && order[1] == 1 && order[2] == 4);
+	TEST_ASSERT(order[3] == 2 && order[4] == 5);
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+/*
+ * Fair-share scheduling test
+ *
+ * Checks a thread yielding all the time keeps running while a CPU-bound
+ * thread got more CPU time than it, instead of waiting a whole time slice at
+ * each yield. Then checks a thread woken up by a CPU-bound thread preempts it
+ * right away, that setting a deadline does not give the CPU away, and that a
+ * higher priority gets a larger share of the CPU.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+#define MS 1000000ULL
+
+static uint64_t now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+volatile int stop;
+int hog_timed_out;
+
+static void hog(void *arg)
+{
+	uint64_t end = now() + 300 * MS;
+
+	while (!stop) {
+		if (now() > end) {
+			hog_timed_out = 1;
+			break;
+		}
+	}
+}
+
+static void yielder(void *arg)
+{
+	for (int i = 0; i < 1000; i++)
+		uthread_yield();
+	stop = 1;
+}
+
+static void yield_client(void *arg)
+{
+	uthread_create(hog, NULL);
+	uthread_create(yielder, NULL);
+}
+
+sem_t wake_sem;
+int woken;
+
+static void sleeper(void *arg)
+{
+	sem_down(wake_sem);
+	woken = 1;
+}
+
+static void waker(void *arg)
+{
+	uint64_t end = now() + 50 * MS;
+
+	/* Let the sleeper block and fall behind */
+	uthread_yield();
+	while (now() < end)
+		;
+
+	TEST_ASSERT(!woken);
+	sem_up(wake_sem);
+	TEST_ASSERT(woken);
+}
+
+static void wake_client(void *arg)
+{
+	uthread_create(sleeper, NULL);
+	uthread_create(waker, NULL);
+}
+
+int other_ran;
+
+static void other(void *arg)
+{
+	other_ran = 1;
+}
+
+static void deadline_client(void *arg)
+{
+	struct uthread_stats stats;
+
+	/* Deadlines mean nothing to this policy, setting one keeps the CPU */
+	uthread_create(other, NULL);
+	uthread_set_deadline(MS);
+	TEST_ASSERT(!other_ran);
+
+	uthread_stats(&stats);
+	TEST_ASSERT(stats.involuntary_switches == 0);
+}
+
+uint64_t end_time;
+uint64_t cpu_time[2];
+
+static void weighted(void *arg)
+{
+	struct uthread_stats stats;
+
+	while (now() < end_time)
+		;
+
+	uthread_stats(&stats);
+	cpu_time[(long) arg] = stats.cpu_time_ns;
+}
+
+static void weight_client(void *arg)
+{
+	uthread_attr_t attr;
+
+	uthread_attr_init(&attr);
+	uthread_create_attr(&attr, weighted, (void*) 0);
+	attr.priority = 5;
+	uthread_create_attr(&attr, weighted, (void*) 1);
+}
+
+int main(void)
+{
+	uthread_opts_t opts;
+
+	uthread_opts_init(&opts);
+	opts.policy = UTHREAD_SCHED_FAIR;
+
+	fprintf(stderr, "*** TEST fair_yield ***\n");
+	uthread_start_opts(&opts, yield_client, NULL);
+	TEST_ASSERT(stop);
+	TEST_ASSERT(!hog_timed_out);
+
+	fprintf(stderr, "*** TEST fair_wakeup ***\n");
+	wake_sem = sem_create(0);
+	uthread_start_opts(&opts, wake_client, NULL);
+	sem_destroy(wake_sem);
+
+	fprintf(stderr, "*** TEST fair_deadline ***\n");
+	uthread_start_opts(&opts, deadline_client, NULL);
+	TEST_ASSERT(other_ran);
+
+	/* Priority 5 has about 3 times the weight of priority 0 */
+	fprintf(stderr, "*** TEST fair_weights ***\n");
+	end_time = now() + 300 * MS;
+	uthread_start_opts(&opts, weight_client, NULL);
+	printf("cpu time: %llu ms at priority 0, %llu ms at priority 5\n",
+	       (unsigned long long) (cpu_time[0] / MS),
+	       (unsigned long long) (cpu_time[1] / MS));
+	TEST_ASSERT(cpu_time[1] > 2 * cpu_time[0]);
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Growable stack test
+ *
+ * Creates threads with a growable stack which only commit a few pages at
+ * creation, and have them recurse far deeper than these pages allow. The
+ * stacks should grow on demand and the threads complete normally.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define NUM_THREADS	4
+#define RESERVED_SIZE	(1024 * 1024)
+#define FRAME_SIZE	1024
+#define RECURSION_DEPTH	512
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int completed;
+
+static int recurse(int depth)
+{
+	volatile char frame[FRAME_SIZE];
+
+	frame[0] = 1;
+	if (depth == RECURSION_DEPTH)
+		return depth;
+
+	/* Interleave the threads while their stacks are deep */
+	if (depth % 64 == 0)
+		uthread_yield();
+
+	return recurse(depth + 1) + frame[0] - 1;
+}
+
+static void deep(void *arg)
+{
+	if (recurse(0) == RECURSION_DEPTH)
+		completed++;
+}
+
+static void spawner(void *arg)
+{
+	uthread_attr_t attr;
+
+	uthread_attr_init(&attr);
+	attr.stack_mode = UTHREAD_STACK_GROWABLE;
+	attr.stack_size = RESERVED_SIZE;
+
+	for (int i = 0; i < NUM_THREADS; i++)
+		TEST_ASSERT(uthread_create_attr(&attr, deep, NULL) == 0);
+
+	/* Size must be a multiple of the page size */
+	attr.stack_size = RESERVED_SIZE + 1;
+	TEST_ASSERT(uthread_create_attr(&attr, deep, NULL) == -1);
+}
+
+int main(void)
+{
+	uthread_start(spawner, NULL);
+
+	TEST_ASSERT(completed == NUM_THREADS);
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Thread handle test
+ *
+ * Checks threads see their own handle, and that the handles of exited
+ * threads are recognized as stale, including once their slot was reused by
+ * a new thread. Also checks no handle to a slot of the arena that was never
+ * handed out is taken for a live thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+uthread_t seen[2];
+uthread_t reused;
+int num_done;
+
+static void record(void *arg)
+{
+	seen[(long) arg] = uthread_self();
+	num_done++;
+}
+
+static void record_reused(void *arg)
+{
+	reused = uthread_self();
+	num_done++;
+}
+
+static void client(void *arg)
+{
+	uthread_func_t funcs[2] = { record, record };
+	void *args[2] = { (void *) 0, (void *) 1 };
+	uthread_t handles[2];
+
+	TEST_ASSERT(uthread_self() != 0);
+	TEST_ASSERT(uthread_alive(uthread_self()));
+
+	TEST_ASSERT(uthread_create_batch(2, funcs, args, handles) == 0);
+	TEST_ASSERT(handles[0] != handles[1]);
+	TEST_ASSERT(uthread_alive(handles[0]) && uthread_alive(handles[1]));
+
+	while (num_done < 2)
+		uthread_yield();
+	TEST_ASSERT(seen[0] == handles[0] && seen[1] == handles[1]);
+	TEST_ASSERT(!uthread_alive(handles[0]) && !uthread_alive(handles[1]));
+
+	/* The next thread reuses the memory of an exited one */
+	uthread_create(record_reused, NULL);
+	while (num_done < 3)
+		uthread_yield();
+	TEST_ASSERT((uint32_t) reused == (uint32_t) handles[1]);
+	TEST_ASSERT(reused != handles[1]);
+	TEST_ASSERT(!uthread_alive(handles[1]));
+
+	TEST_ASSERT(!uthread_alive(0));
+
+	/* Slots of the arena never handed out have no live handle */
+	TEST_ASSERT(!uthread_alive((uint32_t) handles[1] + 10));
+	TEST_ASSERT(!uthread_alive((uthread_t) 1 << 32 |
+				   ((uint32_t) handles[1] + 10)));
+	TEST_ASSERT(!uthread_alive((uthread_t) 1 << 32 | 123456));
+}
+
+int main(void)
+{
+	TEST_ASSERT(uthread_self() == 0);
+
+	uthread_start(client, NULL);
+
+	return 0;
+}
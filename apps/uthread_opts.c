@@ -0,0 +1,132 @@
+/*
+ * Runtime options test
+ *
+ * Pins the runtime to the first CPU the process may run on, and checks the
+ * threads run on it and the previous affinity is restored afterwards. Then
+ * checks invalid CPU sets and policies are rejected. Last, runs threads which
+ * only get to switch through preemption with the signal mask treated as
+ * process-wide.
+ */
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int pinned_cpu;
+int pinned_count;
+int thread_cpus[2];
+
+static void thread2(void *arg)
+{
+	thread_cpus[1] = sched_getcpu();
+}
+
+static void thread1(void *arg)
+{
+	cpu_set_t cpus;
+
+	sched_getaffinity(0, sizeof(cpu_set_t), &cpus);
+	pinned_count = CPU_COUNT(&cpus);
+
+	uthread_create(thread2, NULL);
+	thread_cpus[0] = sched_getcpu();
+	uthread_yield();
+}
+
+static void nothing(void *arg)
+{
+}
+
+volatile int spin_done;
+int spin_preempted;
+
+static void spin_stop(void *arg)
+{
+	spin_done = 1;
+}
+
+static void spinner(void *arg)
+{
+	struct uthread_stats stats;
+
+	uthread_create(spin_stop, NULL);
+
+	/* Only preemption lets spin_stop() run */
+	while (!spin_done)
+		;
+
+	uthread_stats(&stats);
+	spin_preempted = stats.involuntary_switches > 0;
+}
+
+int main(void)
+{
+	cpu_set_t before, after;
+	sigset_t mask;
+	uthread_opts_t opts;
+	int cpu;
+
+	sched_getaffinity(0, sizeof(cpu_set_t), &before);
+	for (cpu = 0; !CPU_ISSET(cpu, &before); cpu++)
+		;
+
+	uthread_opts_init(&opts);
+	TEST_ASSERT(opts.cpus == NULL);
+
+	opts.cpus = &cpu;
+	opts.num_cpus = 1;
+	pinned_cpu = cpu;
+	TEST_ASSERT(uthread_start_opts(&opts, thread1, NULL) == 0);
+
+	TEST_ASSERT(pinned_count == 1);
+	TEST_ASSERT(thread_cpus[0] == pinned_cpu);
+	TEST_ASSERT(thread_cpus[1] == pinned_cpu);
+
+	sched_getaffinity(0, sizeof(cpu_set_t), &after);
+	TEST_ASSERT(CPU_EQUAL(&before, &after));
+
+	/* Invalid CPUs, or no CPU at all, are rejected */
+	cpu = -1;
+	TEST_ASSERT(uthread_start_opts(&opts, nothing, NULL) == -1);
+	cpu = CPU_SETSIZE;
+	TEST_ASSERT(uthread_start_opts(&opts, nothing, NULL) == -1);
+	opts.num_cpus = 0;
+	TEST_ASSERT(uthread_start_opts(&opts, nothing, NULL) == -1);
+
+	/* So is an unknown policy, once pinned, which is undone */
+	cpu = pinned_cpu;
+	opts.num_cpus = 1;
+	opts.policy = (enum uthread_sched_policy) -1;
+	TEST_ASSERT(uthread_start_opts(&opts, nothing, NULL) == -1);
+	sched_getaffinity(0, sizeof(cpu_set_t), &after);
+	TEST_ASSERT(CPU_EQUAL(&before, &after));
+
+	TEST_ASSERT(uthread_start_opts(NULL, nothing, NULL) == 0);
+
+	/* Preemption without ever touching the signal mask */
+	uthread_opts_init(&opts);
+	opts.shared_sigmask = 1;
+	TEST_ASSERT(uthread_start_opts(&opts, spinner, NULL) == 0);
+	TEST_ASSERT(spin_done && spin_preempted);
+
+	sigprocmask(SIG_SETMASK, NULL, &mask);
+	TEST_ASSERT(!sigismember(&mask, SIGVTALRM));
+
+	return 0;
+}
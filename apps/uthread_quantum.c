@@ -0,0 +1,86 @@
+/*
+ * Preemption time slice test
+ *
+ * Runs a thread spinning for a fixed amount of its own CPU time, next to a
+ * ready thread, with a short and then a long time slice, and checks it got
+ * preempted much more often with the short one. CPU time timers only expire on
+ * kernel ticks, so a time slice shorter than a kernel tick lasts a tick.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+/* CPU time the spinner burns, in us */
+#define SPIN_US 120000
+
+uint64_t preemptions;
+
+static uint64_t cpu_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void spinner(void *arg)
+{
+	struct uthread_stats stats;
+	uint64_t start = cpu_time_us();
+
+	while (cpu_time_us() - start < SPIN_US)
+		;
+
+	uthread_stats(&stats);
+	preemptions = stats.preemptions;
+}
+
+static void run(unsigned quantum_us)
+{
+	uthread_opts_t opts;
+
+	uthread_opts_init(&opts);
+	opts.shared_sigmask = 1;
+	opts.quantum_us = quantum_us;
+
+	preemptions = 0;
+	uthread_start_opts(&opts, spinner, NULL);
+}
+
+int main(void)
+{
+	uint64_t short_slices, long_slices;
+
+	fprintf(stderr, "*** TEST quantum_default ***\n");
+	run(0);
+	TEST_ASSERT(preemptions > 0);
+
+	fprintf(stderr, "*** TEST quantum_short ***\n");
+	run(1000);
+	short_slices = preemptions;
+	TEST_ASSERT(short_slices <= SPIN_US / 1000);
+
+	fprintf(stderr, "*** TEST quantum_long ***\n");
+	run(40000);
+	long_slices = preemptions;
+	TEST_ASSERT(long_slices >= 1);
+	TEST_ASSERT(long_slices <= SPIN_US / 40000 * 2);
+	TEST_ASSERT(short_slices > long_slices * 4);
+
+	return 0;
+}
@@ -0,0 +1,201 @@
+/*
+ * Custom scheduling policy test
+ *
+ * Starts the library with a last-in first-out policy of our own, and checks
+ * the threads run in its order rather than the default FIFO one, and that the
+ * library calls the hooks of the policy: init and fini once per run, and
+ * on_block and on_wake for each thread blocked on a semaphore and woken up.
+ * Last, checks a start failing once the policy is initialized releases the
+ * policy and restores the CPU affinity.
+ */
+
+#define _GNU_SOURCE
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#include "private.h"
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+#define MAX_READY 16
+
+struct uthread_tcb *stack[MAX_READY];
+size_t num_ready;
+
+int num_init, num_fini, num_block, num_wake;
+
+static int lifo_init(void)
+{
+	num_ready = 0;
+	num_init++;
+	return 0;
+}
+
+static void lifo_fini(void)
+{
+	num_fini++;
+}
+
+static int lifo_reserve(size_t count)
+{
+	return num_ready + count > MAX_READY ? -1 : 0;
+}
+
+static void lifo_enqueue(struct uthread_tcb *tcb)
+{
+	stack[num_ready++] = tcb;
+}
+
+static struct uthread_tcb *lifo_pick_next(void)
+{
+	return num_ready > 0 ? stack[--num_ready] : NULL;
+}
+
+static size_t lifo_nr_ready(void)
+{
+	return num_ready;
+}
+
+static void lifo_on_block(struct uthread_tcb *tcb)
+{
+	num_block++;
+}
+
+static void lifo_on_wake(struct uthread_tcb *tcb)
+{
+	num_wake++;
+}
+
+/* Cannot make room for any thread, not even the first one */
+static int full_reserve(size_t count)
+{
+	return -1;
+}
+
+static const struct uthread_sched_ops lifo = {
+	.name      = "lifo",
+	.init      = lifo_init,
+	.fini      = lifo_fini,
+	.reserve   = lifo_reserve,
+	.enqueue   = lifo_enqueue,
+	.pick_next = lifo_pick_next,
+	.nr_ready  = lifo_nr_ready,
+	.on_block  = lifo_on_block,
+	.on_wake   = lifo_on_wake,
+};
+
+static const struct uthread_sched_ops full = {
+	.name      = "full",
+	.init      = lifo_init,
+	.fini      = lifo_fini,
+	.reserve   = full_reserve,
+	.enqueue   = lifo_enqueue,
+	.pick_next = lifo_pick_next,
+	.nr_ready  = lifo_nr_ready,
+};
+
+int order[8];
+int num_run;
+
+static void record(void *arg)
+{
+	order[num_run++] = (int) (long) arg;
+}
+
+static void creator(void *arg)
+{
+	for(long id = 1; id <= 4; id++)
+		uthread_create(record, (void*) id);
+
+	/* Nothing may have run before we exit */
+	TEST_ASSERT(num_run == 0);
+}
+
+sem_t sem;
+
+static void sleeper(void *arg)
+{
+	sem_down(sem);
+	record(arg);
+}
+
+static void waker(void *arg)
+{
+	uthread_create(sleeper, (void*) 1L);
+
+	/* The sleeper, last made ready, runs first and blocks */
+	uthread_yield();
+	TEST_ASSERT(num_block == 1);
+
+	sem_up(sem);
+	TEST_ASSERT(num_wake == 1);
+	record((void*) 2L);
+}
+
+int main(void)
+{
+	uthread_opts_t opts;
+	cpu_set_t before, after;
+	int cpu;
+
+	uthread_opts_init(&opts);
+	opts.sched = &lifo;
+
+	fprintf(stderr, "*** TEST sched_order ***\n");
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_init == 1 && num_fini == 1);
+	TEST_ASSERT(num_run == 4);
+	TEST_ASSERT(order[0] == 4 && order[1] == 3);
+	TEST_ASSERT(order[2] == 2 && order[3] == 1);
+
+	fprintf(stderr, "*** TEST sched_hooks ***\n");
+	num_run = 0;
+	sem = sem_create(0);
+	uthread_start_opts(&opts, waker, NULL);
+	sem_destroy(sem);
+	TEST_ASSERT(num_init == 2 && num_fini == 2);
+	TEST_ASSERT(num_block == 1 && num_wake == 1);
+	TEST_ASSERT(num_run == 2);
+
+	fprintf(stderr, "*** TEST sched_default ***\n");
+	num_run = 0;
+	opts.sched = NULL;
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_init == 2);
+	TEST_ASSERT(order[0] == 1 && order[1] == 2);
+	TEST_ASSERT(order[2] == 3 && order[3] == 4);
+
+	fprintf(stderr, "*** TEST sched_abort ***\n");
+	sched_getaffinity(0, sizeof(cpu_set_t), &before);
+	for (cpu = 0; !CPU_ISSET(cpu, &before); cpu++)
+		;
+	num_run = 0;
+	opts.sched = &full;
+	opts.cpus = &cpu;
+	opts.num_cpus = 1;
+	TEST_ASSERT(uthread_start_opts(&opts, record, NULL) == -1);
+	TEST_ASSERT(num_init == 3 && num_fini == 3);
+	TEST_ASSERT(num_run == 0);
+	sched_getaffinity(0, sizeof(cpu_set_t), &after);
+	TEST_ASSERT(CPU_EQUAL(&before, &after));
+
+	/* The library is left usable */
+	TEST_ASSERT(uthread_start(record, NULL) == 0);
+	TEST_ASSERT(num_run == 1);
+
+	return 0;
+}
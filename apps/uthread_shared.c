@@ -0,0 +1,140 @@
+/*
+ * Shared stack test
+ *
+ * Threads running on the shared stack fill local buffers with their own
+ * pattern, yield to each other and to a thread with a dedicated stack while
+ * deep in a recursion, then check their buffers were preserved. Then has
+ * threads on the shared stack block on a semaphore one after the other, and
+ * checks they are all woken up, in order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_THREADS	8
+#define FRAME_SIZE	512
+#define RECURSION_DEPTH	16
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int intact;
+int dedicated_ran;
+
+sem_t sem;
+int order[NUM_THREADS];
+int num_woken;
+
+static int recurse(int id, int depth)
+{
+	volatile char frame[FRAME_SIZE];
+	int ok = 1;
+
+	for (int i = 0; i < FRAME_SIZE; i++)
+		frame[i] = id + depth + i;
+
+	if (depth < RECURSION_DEPTH)
+		ok = recurse(id, depth + 1);
+	else
+		uthread_yield();
+
+	uthread_yield();
+
+	for (int i = 0; i < FRAME_SIZE; i++)
+		if (frame[i] != (char) (id + depth + i))
+			ok = 0;
+
+	return ok;
+}
+
+static void shared(void *arg)
+{
+	int id = (int) (long) arg;
+
+	if (recurse(id, 0))
+		intact++;
+}
+
+static void dedicated(void *arg)
+{
+	for (int i = 0; i < RECURSION_DEPTH; i++)
+		uthread_yield();
+
+	dedicated_ran = 1;
+}
+
+static void spawner(void *arg)
+{
+	uthread_attr_t attr;
+
+	uthread_attr_init(&attr);
+	attr.stack_mode = UTHREAD_STACK_SHARED;
+
+	for (long i = 0; i < NUM_THREADS; i++)
+		TEST_ASSERT(uthread_create_attr(&attr, shared, (void *) i) == 0);
+
+	TEST_ASSERT(uthread_create(dedicated, NULL) == 0);
+}
+
+static void blocker(void *arg)
+{
+	sem_down(sem);
+	order[num_woken++] = (int) (long) arg;
+}
+
+static void releaser(void *arg)
+{
+	for (int i = 0; i < NUM_THREADS; i++)
+		sem_up(sem);
+}
+
+static void blocking_spawner(void *arg)
+{
+	uthread_attr_t attr;
+
+	uthread_attr_init(&attr);
+	attr.stack_mode = UTHREAD_STACK_SHARED;
+
+	for (long i = 0; i < NUM_THREADS; i++)
+		uthread_create_attr(&attr, blocker, (void *) i);
+
+	/* Let all the shared threads block */
+	uthread_yield();
+
+	uthread_create(releaser, NULL);
+}
+
+int main(void)
+{
+	int in_order = 1;
+
+	fprintf(stderr, "*** TEST shared_frames ***\n");
+	uthread_start(spawner, NULL);
+
+	TEST_ASSERT(intact == NUM_THREADS);
+	TEST_ASSERT(dedicated_ran);
+
+	fprintf(stderr, "*** TEST shared_blocking ***\n");
+	sem = sem_create(0);
+	uthread_start(blocking_spawner, NULL);
+
+	for (int i = 0; i < num_woken; i++)
+		if (order[i] != i)
+			in_order = 0;
+	TEST_ASSERT(num_woken == NUM_THREADS);
+	TEST_ASSERT(in_order);
+	TEST_ASSERT(sem_destroy(sem) == 0);
+
+	return 0;
+}
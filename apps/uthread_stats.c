@@ -0,0 +1,73 @@
+/*
+ * Thread statistics test
+ *
+ * Two threads yield to each other a fixed number of times, then one of them
+ * blocks on a semaphore released by the other. The per-thread and whole
+ * runtime counters should reflect these switches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define NUM_YIELDS 10
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+sem_t sem;
+
+static void thread2(void *arg)
+{
+	for (int i = 0; i < NUM_YIELDS; i++)
+		uthread_yield();
+
+	sem_up(sem);
+}
+
+static void thread1(void *arg)
+{
+	struct uthread_stats stats;
+
+	uthread_create(thread2, NULL);
+
+	for (int i = 0; i < NUM_YIELDS; i++)
+		uthread_yield();
+
+	/* Wait for thread2 */
+	sem_down(sem);
+
+	TEST_ASSERT(uthread_stats(&stats) == 0);
+	TEST_ASSERT(stats.voluntary_switches >= NUM_YIELDS + 1);
+	TEST_ASSERT(stats.involuntary_switches <= stats.preemptions);
+	TEST_ASSERT(stats.cpu_time_ns > 0);
+	TEST_ASSERT(stats.blocked_time_ns > 0);
+}
+
+int main(void)
+{
+	struct uthread_stats total;
+
+	sem = sem_create(0);
+
+	uthread_start(thread1, NULL);
+
+	TEST_ASSERT(uthread_stats_total(&total) == 0);
+	TEST_ASSERT(total.voluntary_switches >= 2 * NUM_YIELDS + 1);
+	TEST_ASSERT(total.ready_time_ns > 0);
+	TEST_ASSERT(uthread_stats_total(NULL) == -1);
+
+	sem_destroy(sem);
+
+	return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Run-to-completion task test
+ *
+ * A thread spawns tasks and yields several times: the tasks should all run,
+ * in order, interleaved with the turns of the thread. Tasks can spawn other
+ * tasks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define NUM_TASKS 4
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int order[NUM_TASKS + 1];
+int num_run;
+int thread_turns;
+
+static void nested(void *arg)
+{
+	order[num_run++] = -1;
+}
+
+static void task(void *arg)
+{
+	order[num_run++] = (int) (long) arg;
+
+	if ((long) arg == NUM_TASKS - 1)
+		uthread_spawn_task(nested, NULL);
+}
+
+static void thread(void *arg)
+{
+	for (long i = 0; i < NUM_TASKS; i++)
+		TEST_ASSERT(uthread_spawn_task(task, (void *) i) == 0);
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		uthread_yield();
+		thread_turns++;
+
+		/* A task ran each time the thread gave its turn away */
+		TEST_ASSERT(num_run >= thread_turns);
+	}
+
+	TEST_ASSERT(uthread_spawn_task(NULL, NULL) == -1);
+}
+
+int main(void)
+{
+	uthread_start(thread, NULL);
+
+	TEST_ASSERT(num_run == NUM_TASKS + 1);
+	for (int i = 0; i < NUM_TASKS; i++)
+		TEST_ASSERT(order[i] == i);
+	TEST_ASSERT(order[NUM_TASKS] == -1);
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Uthread-local storage test
+ *
+ * Several threads store their own value under the same key and yield to each
+ * other before reading it back: each thread should read its own value. The
+ * destructor of the key should run once per thread with a non-NULL value.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <uthread.h>
+
+#define NUM_THREADS 4
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+uthread_key_t key;
+int values[NUM_THREADS];
+int destroyed;
+
+static void destructor(void *value)
+{
+	destroyed++;
+}
+
+static void worker(void *arg)
+{
+	int *value = arg;
+
+	TEST_ASSERT(uthread_getspecific(key) == NULL);
+	uthread_setspecific(key, value);
+
+	uthread_yield();
+
+	TEST_ASSERT(uthread_getspecific(key) == value);
+}
+
+static void spawner(void *arg)
+{
+	uthread_key_t other;
+
+	TEST_ASSERT(uthread_key_create(&key, destructor) == 0);
+	TEST_ASSERT(uthread_key_create(&other, NULL) == 0);
+	TEST_ASSERT(other != key);
+	TEST_ASSERT(uthread_setspecific(other + 1, NULL) == -1);
+
+	for (int i = 0; i < NUM_THREADS; i++)
+		uthread_create(worker, &values[i]);
+}
+
+int main(void)
+{
+	uthread_start(spawner, NULL);
+
+	TEST_ASSERT(destroyed == NUM_THREADS);
+
+	return 0;
+}
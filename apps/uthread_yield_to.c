@@ -0,0 +1,110 @@
+/*
+ * Directed yield test
+ *
+ * Checks uthread_yield_to() runs the given thread first, and that with the
+ * FIFO policy the yielding thread takes its place in line, the other threads
+ * keeping their order. Then checks yielding to a thread which is not ready
+ * fails and keeps the caller running, and that the other policies support
+ * directed yields too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sem.h>
+#include <uthread.h>
+
+#define TEST_ASSERT(assert)				\
+do {							\
+	printf("ASSERT: " #assert " ... ");		\
+	if (assert) {					\
+		printf("PASS\n");			\
+	} else	{					\
+		printf("FAIL\n");			\
+		exit(1);				\
+	}						\
+} while(0)
+
+int order[8];
+int num_run;
+int resumed_after;
+
+static void record(void *arg)
+{
+	order[num_run++] = (int) (long) arg;
+}
+
+static void creator(void *arg)
+{
+	uthread_func_t funcs[4] = { record, record, record, record };
+	void *args[4] = { (void*) 1L, (void*) 2L, (void*) 3L, (void*) 4L };
+	uthread_t handles[4];
+
+	uthread_create_batch(4, funcs, args, handles);
+
+	TEST_ASSERT(uthread_yield_to(handles[2]) == 0);
+	resumed_after = num_run;
+
+	/* Exited threads and the running one are not ready */
+	TEST_ASSERT(uthread_yield_to(handles[2]) == -1);
+	TEST_ASSERT(uthread_yield_to(uthread_self()) == -1);
+	TEST_ASSERT(uthread_yield_to(0) == -1);
+}
+
+sem_t sem;
+uthread_t sleeper_handle;
+int woken;
+
+static void sleeper(void *arg)
+{
+	sleeper_handle = uthread_self();
+	sem_down(sem);
+	woken = 1;
+}
+
+static void waker(void *arg)
+{
+	uthread_create(sleeper, NULL);
+	uthread_yield();
+
+	/* The sleeper is blocked, so we keep running */
+	TEST_ASSERT(uthread_yield_to(sleeper_handle) == -1);
+	TEST_ASSERT(!woken);
+
+	sem_up(sem);
+	TEST_ASSERT(uthread_yield_to(sleeper_handle) == 0);
+	TEST_ASSERT(woken);
+}
+
+int main(void)
+{
+	uthread_opts_t opts;
+
+	uthread_opts_init(&opts);
+
+	fprintf(stderr, "*** TEST yield_to_fifo ***\n");
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_run == 4);
+	TEST_ASSERT(order[0] == 3 && order[1] == 1);
+	TEST_ASSERT(order[2] == 2 && order[3] == 4);
+	TEST_ASSERT(resumed_after == 3);
+
+	fprintf(stderr, "*** TEST yield_to_blocked ***\n");
+	sem = sem_create(0);
+	uthread_start_opts(&opts, waker, NULL);
+	sem_destroy(sem);
+
+	fprintf(stderr, "*** TEST yield_to_edf ***\n");
+	num_run = 0;
+	opts.policy = UTHREAD_SCHED_EDF;
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_run == 4 && order[0] == 3);
+
+	fprintf(stderr, "*** TEST yield_to_fair ***\n");
+	num_run = 0;
+	opts.policy = UTHREAD_SCHED_FAIR;
+	uthread_start_opts(&opts, creator, NULL);
+	TEST_ASSERT(num_run == 4 && order[0] == 3);
+
+	return 0;
+}
@@ -1,36 +1,421 @@
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 
 #include "private.h"
 #include "uthread.h"
 
-/* Size of the stack for a thread (in bytes) */
-#define UTHREAD_STACK_SIZE 32768
-
 #define _XOPEN_SOURCE 500
 
+/* Size of the region committed at the top of a growable stack (in bytes) */
+#define UTHREAD_STACK_COMMIT_INIT 16384
+
+/*
+ * Minimum space kept committed below the faulting address when a growable
+ * stack grows (in bytes), so that a signal frame can be pushed without
+ * immediately faulting again
+ */
+#define UTHREAD_STACK_GROW_HEADROOM 16384
+
+/* Size of the alternate stack on which stack faults are handled (in bytes) */
+#define UTHREAD_FAULT_STACK_SIZE 65536
+
+/*
+ * Space left below the frame of uthread_ctx_switch() when saving the shared
+ * stack of a context (in bytes), which covers the call to swapcontext()
+ */
+#define UTHREAD_SHARED_STACK_MARGIN 256
+
+/*
+ * shared_stack - Stack shared by the contexts in UTHREAD_STACK_SHARED mode
+ * shared_stack_users - Number of contexts using the shared stack
+ * shared_stack_owner - Context whose frames are currently on the shared stack
+ */
+static char *shared_stack;
+static size_t shared_stack_users;
+static uthread_ctx_t *shared_stack_owner;
+
+/*
+ * switcher_ctx - Context loading a context on the shared stack
+ * switcher_stack - Stack of switcher_ctx
+ * switcher_next - Context to load and resume
+ *
+ * A context cannot overwrite the shared stack while running on it, so
+ * switching between two contexts on the shared stack goes through
+ * switcher_ctx, which runs on its own stack.
+ */
+static ucontext_t switcher_ctx;
+static char *switcher_stack;
+static uthread_ctx_t *switcher_next;
+
+/*
+ * running_ctx - Context of the currently running thread
+ *
+ * Set right before switching to a context, so that the stack fault handler
+ * knows which stack it may grow.
+ *
+ * leaving_ctx - Context being switched away from
+ *
+ * Until the switch lands on the stack of running_ctx, the code doing the
+ * switch, or a signal handler interrupting it, still runs on the stack of
+ * leaving_ctx, which may need to grow as well.
+ */
+static uthread_ctx_t *running_ctx;
+static uthread_ctx_t *leaving_ctx;
+
+/*
+ * shared_sigmask - Whether the signal mask is treated as process-wide
+ *
+ * If so, switches save and restore contexts with _setjmp() and _longjmp(),
+ * which leave the signal mask alone, instead of swapcontext().
+ */
+static int shared_sigmask;
+
+/*
+ * fault_handler_installed - Whether the stack fault handler is installed
+ * prev_fault_action - Action associated to SIGSEGV before the handler
+ */
+static int fault_handler_installed;
+static struct sigaction prev_fault_action;
+
+static void uthread_ctx_bootstrap(uthread_func_t func, void *arg);
+
+/*
+ * uthread_ctx_load - Make the shared stack hold the frames of a context
+ * @uctx: Context on the shared stack about to be resumed
+ *
+ * The frames of the previous owner of the shared stack are copied to its save
+ * buffer, then the frames of @uctx are copied back from its own. A context
+ * which never ran gets its initial frame set up instead. Must not be called
+ * while running on the shared stack.
+ */
+static void uthread_ctx_load(uthread_ctx_t *uctx)
+{
+	uthread_ctx_t *owner = shared_stack_owner;
+	char *top = shared_stack + UTHREAD_SHARED_STACK_SIZE;
+
+	if (owner != NULL) {
+		size_t used = top - owner->stack_sp;
+
+		/* Keep the save buffer sized to fit the used part */
+		if (used > owner->saved_capacity ||
+		    used < owner->saved_capacity / 4) {
+			char *saved = realloc(owner->saved, used);
+
+			if (saved == NULL) {
+				perror("realloc");
+				exit(1);
+			}
+			owner->saved = saved;
+			owner->saved_capacity = used;
+		}
+
+		memcpy(owner->saved, owner->stack_sp, used);
+		owner->saved_size = used;
+	}
+
+	shared_stack_owner = uctx;
+
+	if (!uctx->started) {
+		makecontext(&uctx->uc, (void (*)(void)) uthread_ctx_bootstrap,
+			    2, uctx->func, uctx->arg);
+		uctx->started = 1;
+	} else {
+		memcpy(top - uctx->saved_size, uctx->saved, uctx->saved_size);
+	}
+}
+
+/*
+ * uthread_ctx_resume - Resume a context, without saving the running one
+ * @uctx: Context to resume
+ *
+ * Only a context run for the first time, or saved by swapcontext(), goes
+ * through setcontext() and thus restores its signal mask.
+ */
+static void uthread_ctx_resume(uthread_ctx_t *uctx)
+{
+	if (uctx->resumable)
+		_longjmp(uctx->jb, 1);
+
+	setcontext(&uctx->uc);
+
+	perror("setcontext");
+	exit(1);
+}
+
+/*
+ * uthread_ctx_switcher - Body of switcher_ctx
+ */
+static void uthread_ctx_switcher(void)
+{
+	uthread_ctx_load(switcher_next);
+	uthread_ctx_resume(switcher_next);
+}
+
+void uthread_ctx_shared_sigmask(int enable)
+{
+	shared_sigmask = enable;
+}
+
 void uthread_ctx_switch(uthread_ctx_t *prev, uthread_ctx_t *next)
 {
+	char marker;
+	ucontext_t *target = &next->uc;
+
+	running_ctx = next;
+	leaving_ctx = prev;
+
+	/* Remember how much of the shared stack @prev is using */
+	if (prev->shared)
+		prev->stack_sp = (char *) ((uintptr_t) &marker -
+					   UTHREAD_SHARED_STACK_MARGIN);
+
+	if (next->shared && shared_stack_owner != next) {
+		if (prev->shared) {
+			/* Load @next from the switcher's own stack */
+			switcher_next = next;
+			makecontext(&switcher_ctx, uthread_ctx_switcher, 0);
+			target = &switcher_ctx;
+		} else {
+			uthread_ctx_load(next);
+		}
+	}
+
+	/*
+	 * With a process-wide signal mask, only the registers of @prev need to
+	 * be saved, and _setjmp() returns a second time once @prev is resumed
+	 */
+	if (shared_sigmask) {
+		if (_setjmp(prev->jb)) {
+			leaving_ctx = NULL;
+			return;
+		}
+		prev->resumable = 1;
+
+		if (target == &switcher_ctx) {
+			setcontext(target);
+			perror("setcontext");
+			exit(1);
+		}
+		uthread_ctx_resume(next);
+	}
+
 	/*
 	 * swapcontext() saves the current context in structure pointer by @prev
 	 * and actives the context pointed by @next
 	 */
-
-	if (swapcontext(prev, next)) {
+	prev->resumable = 0;
+	if (swapcontext(&prev->uc, target)) {
 		perror("swapcontext");
 		exit(1);
 	}
+	leaving_ctx = NULL;
 }
 
-void *uthread_ctx_alloc_stack(void)
+void uthread_ctx_release(uthread_ctx_t *uctx)
 {
-	return malloc(UTHREAD_STACK_SIZE);
+	if (shared_stack_owner == uctx)
+		shared_stack_owner = NULL;
+
+	free(uctx->saved);
+	uctx->saved = NULL;
+	uctx->saved_size = 0;
+	uctx->saved_capacity = 0;
 }
 
-void uthread_ctx_destroy_stack(void *top_of_stack)
+/*
+ * uthread_ctx_commit - Commit a growable stack down to a given address
+ * @uctx: Context of which to grow the stack
+ * @addr: Lowest address which must be committed
+ *
+ * Return: 0 if the stack now covers @addr, -1 if @addr is beyond the stack's
+ * limit or in case of failure
+ */
+static int uthread_ctx_commit(uthread_ctx_t *uctx, char *addr)
 {
-	free(top_of_stack);
+	uintptr_t page_size = sysconf(_SC_PAGESIZE);
+	char *low;
+
+	if (addr < uctx->stack_guard)
+		return -1;
+
+	/* Round down to a page, leaving some headroom below */
+	if (addr - uctx->stack_guard > UTHREAD_STACK_GROW_HEADROOM)
+		low = addr - UTHREAD_STACK_GROW_HEADROOM;
+	else
+		low = uctx->stack_guard;
+	low = (char *) ((uintptr_t) low & ~(page_size - 1));
+
+	if (mprotect(low, uctx->stack_committed - low, PROT_READ | PROT_WRITE))
+		return -1;
+
+	uctx->stack_committed = low;
+	return 0;
+}
+
+/*
+ * uthread_ctx_fault_handler - Grow the running thread's stack on demand
+ *
+ * Runs on an alternate stack when the running thread touches a reserved but
+ * not yet committed page of its growable stack. Any other fault is handed back
+ * to the previous action by restoring it and returning, which re-executes the
+ * faulting instruction.
+ */
+static void uthread_ctx_fault_handler(int signum, siginfo_t *info,
+				      void *ucontext)
+{
+	char *addr = info->si_addr;
+	uthread_ctx_t *uctx = running_ctx;
+
+	(void) signum;
+	(void) ucontext;
+
+	/* Still on the stack being left, in the middle of a switch */
+	if (leaving_ctx != NULL && leaving_ctx->stack_committed != NULL &&
+	    addr >= leaving_ctx->stack_guard &&
+	    addr < leaving_ctx->stack_committed)
+		uctx = leaving_ctx;
+
+	if (uctx != NULL && uctx->stack_committed != NULL) {
+		/* Regular fault in the reserved range */
+		if (addr >= uctx->stack_guard && addr < uctx->stack_committed &&
+		    !uthread_ctx_commit(uctx, addr))
+			return;
+
+		/*
+		 * The kernel could not push a signal frame below the committed
+		 * range, and does not report where: grow by the headroom
+		 */
+		if (info->si_code == SI_KERNEL &&
+		    uctx->stack_committed > uctx->stack_guard &&
+		    !uthread_ctx_commit(uctx, uctx->stack_committed - 1))
+			return;
+	}
+
+	sigaction(SIGSEGV, &prev_fault_action, NULL);
+}
+
+/*
+ * uthread_ctx_install_fault_handler - Install the stack fault handler
+ *
+ * Return: 0 if the handler is installed, -1 in case of failure
+ */
+static int uthread_ctx_install_fault_handler(void)
+{
+	stack_t fault_stack;
+	struct sigaction fault_action;
+
+	if (fault_handler_installed)
+		return 0;
+
+	/*
+	 * The faulting stack cannot be used to handle the fault, so run the
+	 * handler on an alternate stack
+	 */
+	fault_stack.ss_sp = malloc(UTHREAD_FAULT_STACK_SIZE);
+	fault_stack.ss_size = UTHREAD_FAULT_STACK_SIZE;
+	fault_stack.ss_flags = 0;
+	if (fault_stack.ss_sp == NULL || sigaltstack(&fault_stack, NULL)) {
+		free(fault_stack.ss_sp);
+		return -1;
+	}
+
+	/*
+	 * A preemption tick must not switch away while on the alternate stack,
+	 * or the next fault would reuse it under the preempted handler
+	 */
+	sigemptyset(&fault_action.sa_mask);
+	sigaddset(&fault_action.sa_mask, SIGVTALRM);
+	fault_action.sa_sigaction = uthread_ctx_fault_handler;
+	fault_action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	if (sigaction(SIGSEGV, &fault_action, &prev_fault_action))
+		return -1;
+
+	fault_handler_installed = 1;
+	return 0;
+}
+
+void *uthread_ctx_alloc_stack(size_t stack_size,
+			      enum uthread_stack_mode stack_mode)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	char *stack;
+
+	if (stack_mode == UTHREAD_STACK_FIXED)
+		return malloc(stack_size);
+
+	if (stack_mode == UTHREAD_STACK_SHARED) {
+		/* Set up the shared stack and its switcher on first use */
+		if (shared_stack == NULL) {
+			shared_stack = malloc(UTHREAD_SHARED_STACK_SIZE);
+			switcher_stack = malloc(UTHREAD_STACK_SIZE);
+
+			if (shared_stack == NULL || switcher_stack == NULL ||
+			    getcontext(&switcher_ctx)) {
+				free(shared_stack);
+				free(switcher_stack);
+				shared_stack = NULL;
+				switcher_stack = NULL;
+				return NULL;
+			}
+
+			switcher_ctx.uc_stack.ss_sp = switcher_stack;
+			switcher_ctx.uc_stack.ss_size = UTHREAD_STACK_SIZE;
+			switcher_ctx.uc_link = NULL;
+		}
+
+		shared_stack_users++;
+		return shared_stack;
+	}
+
+	/* Room for the guard page and the initially committed pages */
+	if (stack_size % page_size ||
+	    stack_size < UTHREAD_STACK_COMMIT_INIT + page_size)
+		return NULL;
+
+	if (uthread_ctx_install_fault_handler())
+		return NULL;
+
+	/* Reserve the whole range, without committing any memory */
+	stack = mmap(NULL, stack_size, PROT_NONE,
+		     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (stack == MAP_FAILED)
+		return NULL;
+
+	/* Only commit the topmost pages, where the stack starts */
+	if (mprotect(stack + stack_size - UTHREAD_STACK_COMMIT_INIT,
+		     UTHREAD_STACK_COMMIT_INIT, PROT_READ | PROT_WRITE)) {
+		munmap(stack, stack_size);
+		return NULL;
+	}
+
+	return stack;
+}
+
+void uthread_ctx_destroy_stack(void *top_of_stack, size_t stack_size,
+			       enum uthread_stack_mode stack_mode)
+{
+	if (stack_mode == UTHREAD_STACK_FIXED) {
+		free(top_of_stack);
+	} else if (stack_mode == UTHREAD_STACK_SHARED) {
+		/* The last user of the shared stack frees it */
+		if (top_of_stack == NULL || --shared_stack_users > 0)
+			return;
+
+		free(shared_stack);
+		free(switcher_stack);
+		shared_stack = NULL;
+		switcher_stack = NULL;
+		shared_stack_owner = NULL;
+	} else if (top_of_stack != NULL) {
+		munmap(top_of_stack, stack_size);
+	}
 }
 
 /*
@@ -40,6 +425,8 @@ void uthread_ctx_destroy_stack(void *top_of_stack)
  */
 static void uthread_ctx_bootstrap(uthread_func_t func, void *arg)
 {
+	leaving_ctx = NULL;
+
 	/*
 	 * Enable interrupts right after being elected to run for the first time
 	 */
@@ -51,19 +438,53 @@ static void uthread_ctx_bootstrap(uthread_func_t func, void *arg)
 }
 
 int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
+		     size_t stack_size, enum uthread_stack_mode stack_mode,
 		     uthread_func_t func, void *arg)
 {
 	/*
 	 * Initialize the passed context @uctx to the currently active context
 	 */
-	if (getcontext(uctx))
+	if (getcontext(&uctx->uc))
 		return -1;
 
 	/*
 	 * Change context @uctx's stack to the specified stack
 	 */
-	uctx->uc_stack.ss_sp = top_of_stack;
-	uctx->uc_stack.ss_size = UTHREAD_STACK_SIZE;
+	uctx->uc.uc_stack.ss_sp = top_of_stack;
+	uctx->uc.uc_stack.ss_size = stack_size;
+
+	uctx->shared = 0;
+	uctx->started = 1;
+	uctx->saved = NULL;
+	uctx->saved_size = 0;
+	uctx->saved_capacity = 0;
+	uctx->resumable = 0;
+
+	/*
+	 * A growable stack starts with its topmost pages committed, and may
+	 * grow down to its guard page
+	 */
+	if (stack_mode == UTHREAD_STACK_GROWABLE) {
+		uctx->stack_guard = (char *) top_of_stack + sysconf(_SC_PAGESIZE);
+		uctx->stack_committed = (char *) top_of_stack + stack_size -
+			UTHREAD_STACK_COMMIT_INIT;
+	} else {
+		uctx->stack_guard = NULL;
+		uctx->stack_committed = NULL;
+	}
+
+	/*
+	 * Setting up the initial frame writes to the stack, which may be in use
+	 * by another context: postpone it until first switched to
+	 */
+	if (stack_mode == UTHREAD_STACK_SHARED) {
+		uctx->uc.uc_stack.ss_size = UTHREAD_SHARED_STACK_SIZE;
+		uctx->shared = 1;
+		uctx->started = 0;
+		uctx->func = func;
+		uctx->arg = arg;
+		return 0;
+	}
 
 	/*
 	 * Finish setting up context @uctx:
@@ -72,9 +493,36 @@ int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
 	 * - when called, function uthread_ctx_bootstrap() will receive two
 	 *   arguments: @func and @arg
 	 */
-	makecontext(uctx, (void (*)(void)) uthread_ctx_bootstrap,
+	makecontext(&uctx->uc, (void (*)(void)) uthread_ctx_bootstrap,
 		    2, func, arg);
 
 	return 0;
 }
 
+void uthread_ctx_init_from(uthread_ctx_t *uctx, const uthread_ctx_t *model,
+			   void *top_of_stack, size_t stack_size,
+			   uthread_func_t func, void *arg)
+{
+	*uctx = *model;
+
+#if defined(__x86_64__) || defined(__i386__)
+	/*
+	 * On x86, the FP state is not part of the machine context but pointed to
+	 * by it, and getcontext() points it inside of the context: point it at
+	 * the same place inside of the copy rather than of @model
+	 */
+	const char *base = (const char *) &model->uc;
+	const char *fpregs = (const char *) model->uc.uc_mcontext.fpregs;
+
+	if (fpregs >= base && fpregs < base + sizeof(model->uc))
+		uctx->uc.uc_mcontext.fpregs = (fpregset_t)
+			((char *) &uctx->uc + (fpregs - base));
+#endif
+
+	uctx->uc.uc_stack.ss_sp = top_of_stack;
+	uctx->uc.uc_stack.ss_size = stack_size;
+	uctx->resumable = 0;
+
+	makecontext(&uctx->uc, (void (*)(void)) uthread_ctx_bootstrap,
+		    2, func, arg);
+}
@@ -0,0 +1,278 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "executor.h"
+#include "private.h"
+#include "queue.h"
+#include "sem.h"
+#include "uthread.h"
+
+#define ERROR   -1
+#define NO_ERROR 0
+
+/*
+ * future - non-user level job and its completion state
+ * 
+ * A future doubles as the job it is the handle of, so
+ * submitting a job only allocates one object.
+ * 
+ * 1. func, arg   : the job to run
+ * 
+ * 2. result      : value returned by func, once done
+ * 
+ * 3. done        : whether the job has run
+ * 
+ * 4. waiter      : thread parked in future_wait(), if
+ *                  any, to unblock once done
+ */
+typedef struct future
+{
+    executor_func_t func;
+    void *arg;
+    void *result;
+    bool done;
+    struct uthread_tcb *waiter;
+
+} future;
+
+/*
+ * executor - non-user level pool of worker threads
+ * 
+ * 1. jobs        : futures submitted but not yet run,
+ *                  in submission order
+ * 
+ * 2. idle        : wait records of the workers parked
+ *                  while there is nothing to run, the
+ *                  last parked one first
+ * 
+ * 3. num_idle    : # of workers in idle, so that a job
+ *                  only wakes a worker if one is parked
+ * 
+ * 4. exited      : counts the workers which exited, for
+ *                  executor_destroy() to wait on
+ * 
+ * 5. num_workers : # of worker threads
+ * 
+ * 6. stopping    : set by executor_destroy(), tells
+ *                  workers to exit once jobs is empty
+ */
+typedef struct executor
+{
+    queue_t jobs;
+    struct uthread_waiter *idle;
+    size_t num_idle;
+    sem_t exited;
+    size_t num_workers;
+    bool stopping;
+
+} executor;
+
+/*
+ * executor_wake - Unpark the last parked worker
+ * @executor: Executor the worker belongs to
+ *
+ * Must be called with preemption disabled, and at least one worker parked.
+ * Returns with preemption disabled, although uthread_unblock() enables it
+ * on its way out: preemption does not nest. The most recently parked worker
+ * is the likeliest to still be in cache.
+ */
+static void executor_wake(executor_t executor)
+{
+    struct uthread_waiter *worker = executor->idle;
+
+    executor->idle = worker->next;
+    executor->num_idle--;
+
+    uthread_unblock(worker->thread);
+    preempt_disable();
+}
+
+/*
+ * executor_worker - Body of the worker threads
+ * @arg: Executor the worker belongs to
+ */
+static void executor_worker(void *arg)
+{
+    executor_t executor = arg;
+    future_t job;
+
+    while(true)
+    {
+        preempt_disable();
+
+        bool found = queue_dequeue(executor->jobs, (void**) &job) == 0;
+
+        /* Park until there is a job, or until asked to stop. Another
+           worker may have taken the job we were woken up for, in 
+           which case we park again. */
+        while(!found && !executor->stopping)
+        {
+            struct uthread_waiter *self = uthread_waiter(uthread_current());
+
+            self->next = executor->idle;
+            executor->idle = self;
+            executor->num_idle++;
+
+            uthread_block();
+            preempt_disable();
+
+            found = queue_dequeue(executor->jobs, (void**) &job) == 0;
+        }
+
+        preempt_enable();
+
+        if(!found)
+            break;
+
+        void *result = job->func(job->arg);
+
+        /* Publish the result, and wake up the waiter if it is parked */
+        preempt_disable();
+
+        job->result = result;
+        job->done   = true;
+        if(job->waiter != NULL)
+            uthread_unblock(job->waiter);
+
+        preempt_enable();
+    }
+
+    sem_up(executor->exited);
+}
+
+executor_t executor_create(size_t num_workers)
+{
+    if(num_workers == 0)
+        return NULL;
+
+    preempt_disable();
+
+    executor_t new_executor = malloc(sizeof(executor));
+    if(new_executor == NULL) {
+        preempt_enable();
+        return NULL;
+    }
+
+    new_executor->jobs        = queue_create();
+    new_executor->idle        = NULL;
+    new_executor->num_idle    = 0;
+    new_executor->exited      = sem_create(0);
+    new_executor->num_workers = 0;
+    new_executor->stopping    = false;
+
+    preempt_enable();
+
+    if(new_executor->jobs == NULL || new_executor->exited == NULL) {
+        executor_destroy(new_executor);
+        return NULL;
+    }
+
+    /* Start the workers, which park right away */
+    for(size_t i = 0; i < num_workers; i++)
+    {
+        if(uthread_create(executor_worker, new_executor)) {
+            executor_destroy(new_executor);
+            return NULL;
+        }
+
+        new_executor->num_workers++;
+    }
+
+    return new_executor;
+}
+
+int executor_destroy(executor_t executor)
+{
+    if(executor == NULL)
+        return ERROR;
+
+    /* Wake every parked worker up, so that each of them finds 
+       the job queue empty and exits. The busy ones exit as soon 
+       as they find it empty. */
+    preempt_disable();
+
+    executor->stopping = true;
+    while(executor->num_idle > 0)
+        executor_wake(executor);
+
+    preempt_enable();
+
+    for(size_t i = 0; i < executor->num_workers; i++)
+        sem_down(executor->exited);
+
+    sem_destroy(executor->exited);
+
+    preempt_disable();
+    queue_destroy(executor->jobs);
+    free(executor);
+    preempt_enable();
+
+    return NO_ERROR;
+}
+
+future_t executor_submit(executor_t executor, executor_func_t func, void *arg)
+{
+    if(executor == NULL || func == NULL)
+        return NULL;
+
+    /* Allocate with preemption disabled, as the allocator 
+       cannot be reentered by another thread */
+    preempt_disable();
+
+    future_t job = malloc(sizeof(future));
+    if(job == NULL) {
+        preempt_enable();
+        return NULL;
+    }
+
+    job->func   = func;
+    job->arg    = arg;
+    job->result = NULL;
+    job->done   = false;
+    job->waiter = NULL;
+
+    if(queue_enqueue(executor->jobs, job)) {
+        free(job);
+        preempt_enable();
+        return NULL;
+    }
+
+    /* Wake one parked worker up for the job, if any: the busy 
+       ones take it otherwise, once done with their own */
+    if(executor->num_idle > 0)
+        executor_wake(executor);
+
+    preempt_enable();
+
+    return job;
+}
+
+int future_wait(future_t future, void **result)
+{
+    if(future == NULL)
+        return ERROR;
+
+    preempt_disable();
+
+    if(future->waiter != NULL) {
+        preempt_enable();
+        return ERROR;
+    }
+
+    /* Park until the worker running the job unblocks us */
+    while(!future->done)
+    {
+        future->waiter = uthread_current();
+        uthread_block();
+        preempt_disable();
+    }
+
+    if(result != NULL)
+        *result = future->result;
+    free(future);
+
+    preempt_enable();
+
+    return NO_ERROR;
+}
@@ -0,0 +1,82 @@
+#ifndef _EXECUTOR_H
+#define _EXECUTOR_H
+
+#include <stddef.h>
+
+/*
+ * executor_t - Executor type
+ *
+ * An executor is a pool of long-lived worker threads, which run the jobs
+ * submitted to it in submission order. Reusing the same workers for every job
+ * avoids paying for a thread creation per job.
+ */
+typedef struct executor *executor_t;
+
+/*
+ * future_t - Future type
+ *
+ * A future is the handle of a job submitted to an executor, through which the
+ * result of the job can be waited for.
+ */
+typedef struct future *future_t;
+
+/*
+ * executor_func_t - Job function type
+ * @arg: Argument to be passed to the job
+ *
+ * Return: Result of the job, as received by future_wait()
+ */
+typedef void *(*executor_func_t)(void *arg);
+
+/*
+ * executor_create - Create an executor
+ * @num_workers: Number of worker threads
+ *
+ * Create an executor and its @num_workers worker threads. This function must
+ * be called from a thread, after uthread_start().
+ *
+ * Return: Pointer to new executor. NULL if @num_workers is 0 or in case of
+ * failure when creating the executor or its workers.
+ */
+executor_t executor_create(size_t num_workers);
+
+/*
+ * executor_destroy - Deallocate an executor
+ * @executor: Executor to deallocate
+ *
+ * Wait for the jobs already submitted to @executor to be run and for its
+ * workers to exit, then deallocate @executor. The futures of these jobs remain
+ * valid.
+ *
+ * Return: -1 if @executor is NULL. 0 if @executor was successfully destroyed.
+ */
+int executor_destroy(executor_t executor);
+
+/*
+ * executor_submit - Submit a job to an executor
+ * @executor: Executor which should run the job
+ * @func: Function to be executed by the job
+ * @arg: Argument to be passed to the job
+ *
+ * Queue a job running @func with argument @arg. The job is run by the first
+ * worker of @executor to become available.
+ *
+ * Return: Future of the job, which must be waited for with future_wait(). NULL
+ * if @executor or @func are NULL, or in case of memory allocation error.
+ */
+future_t executor_submit(executor_t executor, executor_func_t func, void *arg);
+
+/*
+ * future_wait - Wait for the completion of a job
+ * @future: Future of the job to wait for
+ * @result: Address where to store the result of the job, or NULL
+ *
+ * Block the calling thread until the job of @future has run, then deallocate
+ * @future. Each future must be waited for exactly once.
+ *
+ * Return: -1 if @future is NULL or already has a waiter. 0 if the job ran and
+ * its result was stored in @result.
+ */
+int future_wait(future_t future, void **result);
+
+#endif /* _EXECUTOR_H */
@@ -0,0 +1,133 @@
+#include <stddef.h>
+
+#include "forkjoin.h"
+#include "private.h"
+#include "uthread.h"
+
+#define ERROR   -1
+#define NO_ERROR 0
+
+/*
+ * forkjoin_range - non-user level chunk of a parallel loop
+ *
+ * Lives on the stack of the thread splitting the loop,
+ * which outlives the child it is given to, so splitting
+ * a loop never allocates any memory.
+ *
+ * 1. begin, end  : indexes of the chunk
+ *
+ * 2. grain       : largest chunk handed to func
+ *
+ * 3. func, ctx   : loop body and its context
+ */
+struct forkjoin_range
+{
+    size_t begin;
+    size_t end;
+    size_t grain;
+    uthread_range_func_t func;
+    void *ctx;
+
+};
+
+int uthread_spawn(uthread_join_t *join, uthread_func_t func, void *arg)
+{
+    if(join == NULL || func == NULL)
+        return ERROR;
+
+    preempt_disable();
+    join->pending++;
+    preempt_enable();
+
+    /* No other worker may take the child, run it right away */
+    func(arg);
+
+    preempt_disable();
+
+    /* Wake up the thread in uthread_sync(), if it waits for us */
+    if(--join->pending == 0 && join->waiter != NULL) {
+        struct uthread_tcb *waiter = join->waiter;
+
+        join->waiter = NULL;
+        uthread_unblock(waiter);
+    }
+
+    preempt_enable();
+
+    return NO_ERROR;
+}
+
+int uthread_sync(uthread_join_t *join)
+{
+    if(join == NULL)
+        return ERROR;
+
+    preempt_disable();
+
+    if(join->waiter != NULL) {
+        preempt_enable();
+        return ERROR;
+    }
+
+    /* Park until the last pending child unblocks us */
+    while(join->pending > 0)
+    {
+        join->waiter = uthread_current();
+        uthread_block();
+        preempt_disable();
+    }
+
+    preempt_enable();
+
+    return NO_ERROR;
+}
+
+/*
+ * forkjoin_split - Run a chunk of a parallel loop
+ * @arg: Chunk to run
+ *
+ * Spawn the first half of the chunk and keep the second one, until what is
+ * left fits in one grain.
+ */
+static void forkjoin_split(void *arg)
+{
+    struct forkjoin_range *range = arg;
+    uthread_join_t join = UTHREAD_JOIN_INIT;
+    size_t begin = range->begin;
+    size_t end   = range->end;
+
+    while(end - begin > range->grain)
+    {
+        struct forkjoin_range half = *range;
+
+        half.begin = begin;
+        half.end   = begin + (end - begin) / 2;
+        begin      = half.end;
+
+        uthread_spawn(&join, forkjoin_split, &half);
+    }
+
+    if(begin < end)
+        range->func(begin, end, range->ctx);
+
+    uthread_sync(&join);
+}
+
+int uthread_parallel_for(size_t begin, size_t end, size_t grain,
+                         uthread_range_func_t func, void *ctx)
+{
+    if(func == NULL || begin > end)
+        return ERROR;
+
+    struct forkjoin_range range = {
+        .begin = begin,
+        .end   = end,
+        .grain = grain ? grain : 1,
+        .func  = func,
+        .ctx   = ctx,
+    };
+
+    forkjoin_split(&range);
+
+    return NO_ERROR;
+}
@@ -0,0 +1,80 @@
+#ifndef _FORKJOIN_H
+#define _FORKJOIN_H
+
+#include <stddef.h>
+
+#include "uthread.h"
+
+/*
+ * uthread_join_t - Fork/join scope
+ *
+ * A join scope counts the children spawned into it which did not complete
+ * yet, so that uthread_sync() can wait for all of them. A scope is usually a
+ * local variable of the function spawning the children, but it can also be
+ * shared by several threads. It must be initialized with UTHREAD_JOIN_INIT,
+ * and its fields are private to the library.
+ */
+typedef struct uthread_join {
+	size_t pending;
+	struct uthread_tcb *waiter;
+} uthread_join_t;
+
+#define UTHREAD_JOIN_INIT { 0, NULL }
+
+/*
+ * uthread_range_func_t - Loop body type
+ * @begin: First index of the chunk
+ * @end: Index following the last index of the chunk
+ * @ctx: Context given to uthread_parallel_for()
+ */
+typedef void (*uthread_range_func_t)(size_t begin, size_t end, void *ctx);
+
+/*
+ * uthread_spawn - Spawn a child into a join scope
+ * @join: Join scope of the child
+ * @func: Function to be executed by the child
+ * @arg: Argument to be passed to the child
+ *
+ * The child is counted in @join until it completes. The runtime runs on a
+ * single kernel thread, so no idle worker can ever take the child over: it is
+ * run inline, on the stack of the calling thread, before uthread_spawn()
+ * returns. The child may block, in which case the calling thread blocks with
+ * it.
+ *
+ * Return: -1 if @join or @func are NULL. 0 once the child completed.
+ */
+int uthread_spawn(uthread_join_t *join, uthread_func_t func, void *arg);
+
+/*
+ * uthread_sync - Wait for the children of a join scope
+ * @join: Join scope to wait for
+ *
+ * Block the calling thread until every child spawned into @join, by any
+ * thread, completed. Only one thread may wait on a given scope at a time.
+ *
+ * Return: -1 if @join is NULL or already has a waiter. 0 once all the
+ * children completed.
+ */
+int uthread_sync(uthread_join_t *join);
+
+/*
+ * uthread_parallel_for - Run a loop body over a range of indexes
+ * @begin: First index of the range
+ * @end: Index following the last index of the range
+ * @grain: Largest chunk of indexes given to one call of @func, 0 meaning 1
+ * @func: Loop body, called on disjoint chunks covering the whole range
+ * @ctx: Context to be passed to @func
+ *
+ * The range is split in halves recursively, the first half being spawned as
+ * a child and the second one handled by the caller, until chunks are at most
+ * @grain indexes long. Chunks are therefore run in increasing order on a
+ * single kernel thread. @grain should be large enough for one chunk to
+ * outweigh the cost of a call.
+ *
+ * Return: -1 if @func is NULL or @begin is greater than @end. 0 once @func
+ * returned for the whole range.
+ */
+int uthread_parallel_for(size_t begin, size_t end, size_t grain,
+			 uthread_range_func_t func, void *ctx);
+
+#endif /* _FORKJOIN_H */
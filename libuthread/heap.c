@@ -0,0 +1,249 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "heap.h"
+
+#define ERROR_FOUND     -1
+#define NO_ERROR         0
+
+/* Capacity of a new heap */
+#define HEAP_MIN_CAPACITY 16
+
+/*
+ * heap_entry - non-user level item of a heap
+ * 
+ * 1. key   : key of the item
+ * 
+ * 2. seq   : push order of the item, breaking ties
+ *            between equal keys in FIFO order
+ * 
+ * 3. data  : the item itself
+ */
+struct heap_entry {
+    uint64_t key;
+    uint64_t seq;
+    void *data;
+};
+
+/*
+ * heap - non-user level d-ary min-heap
+ * 
+ * 1. entries   : array of the items, the children of
+ *                entry i being entries i * HEAP_ARITY + 1
+ *                to i * HEAP_ARITY + HEAP_ARITY
+ * 
+ * 2. capacity  : # of slots in entries
+ * 
+ * 3. length    : # of items in the heap
+ * 
+ * 4. next_seq  : push order of the next item
+ */
+typedef struct heap {
+    struct heap_entry *entries;
+    size_t capacity;
+    size_t length;
+    uint64_t next_seq;
+} heap;
+
+/* Whether entry @a must be popped before entry @b */
+static inline int heap_before(const struct heap_entry *a,
+                              const struct heap_entry *b)
+{
+    return a->key < b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+heap_t heap_create(void)
+{
+    heap_t new_heap = malloc(sizeof(heap));
+
+    if(new_heap == NULL)
+        return NULL;
+
+    new_heap->entries = malloc(HEAP_MIN_CAPACITY * sizeof(struct heap_entry));
+    if(new_heap->entries == NULL) {
+        free(new_heap);
+        return NULL;
+    }
+
+    new_heap->capacity = HEAP_MIN_CAPACITY;
+    new_heap->length   = 0;
+    new_heap->next_seq = 0;
+
+    return new_heap;
+}
+
+int heap_destroy(heap_t heap)
+{
+    if(heap == NULL)
+        return ERROR_FOUND;
+
+    free(heap->entries);
+    free(heap);
+
+    return NO_ERROR;
+}
+
+int heap_reserve(heap_t heap, size_t count)
+{
+    if(heap == NULL)
+        return ERROR_FOUND;
+
+    size_t capacity = heap->capacity;
+
+    while(capacity - heap->length < count)
+        capacity *= 2;
+
+    if(capacity == heap->capacity)
+        return NO_ERROR;
+
+    struct heap_entry *entries = realloc(heap->entries,
+                                         capacity * sizeof(struct heap_entry));
+    if(entries == NULL)
+        return ERROR_FOUND;
+
+    heap->entries  = entries;
+    heap->capacity = capacity;
+
+    return NO_ERROR;
+}
+
+/*
+ * heap_sift_up - Place an entry at or above a free slot
+ * @heap: Heap to place the entry in
+ * @i: Index of the free slot
+ * @entry: Entry to place
+ *
+ * Move the parents after @entry down, until @entry finds its place.
+ */
+static void heap_sift_up(heap_t heap, size_t i, struct heap_entry entry)
+{
+    while(i > 0)
+    {
+        size_t parent = (i - 1) / HEAP_ARITY;
+
+        if(!heap_before(&entry, &heap->entries[parent]))
+            break;
+
+        heap->entries[i] = heap->entries[parent];
+        i = parent;
+    }
+
+    heap->entries[i] = entry;
+}
+
+/*
+ * heap_sift_down - Place an entry at or below a free slot
+ * @heap: Heap to place the entry in
+ * @i: Index of the free slot
+ * @entry: Entry to place
+ *
+ * Move the smallest child up, until @entry finds its place.
+ */
+static void heap_sift_down(heap_t heap, size_t i, struct heap_entry entry)
+{
+    size_t length = heap->length;
+
+    for(;;)
+    {
+        size_t first = i * HEAP_ARITY + 1;
+        size_t smallest;
+
+        if(first >= length)
+            break;
+
+        smallest = first;
+        for(size_t child = first + 1;
+            child < first + HEAP_ARITY && child < length; child++)
+        {
+            if(heap_before(&heap->entries[child], &heap->entries[smallest]))
+                smallest = child;
+        }
+
+        if(!heap_before(&heap->entries[smallest], &entry))
+            break;
+
+        heap->entries[i] = heap->entries[smallest];
+        i = smallest;
+    }
+
+    heap->entries[i] = entry;
+}
+
+int heap_push(heap_t heap, uint64_t key, void *data)
+{
+    if(heap == NULL || data == NULL)
+        return ERROR_FOUND;
+
+    if(heap->length == heap->capacity && heap_reserve(heap, 1))
+        return ERROR_FOUND;
+
+    struct heap_entry entry = { key, heap->next_seq++, data };
+
+    heap_sift_up(heap, heap->length++, entry);
+
+    return NO_ERROR;
+}
+
+int heap_pop(heap_t heap, void **data)
+{
+    if(heap == NULL || data == NULL || heap->length == 0)
+        return ERROR_FOUND;
+
+    *data = heap->entries[0].data;
+
+    /* Move the last item to the root */
+    struct heap_entry last = heap->entries[--heap->length];
+
+    if(heap->length > 0)
+        heap_sift_down(heap, 0, last);
+
+    return NO_ERROR;
+}
+
+int heap_remove(heap_t heap, void *data)
+{
+    if(heap == NULL || data == NULL)
+        return ERROR_FOUND;
+
+    size_t i;
+
+    for(i = 0; i < heap->length; i++)
+        if(heap->entries[i].data == data)
+            break;
+
+    if(i == heap->length)
+        return ERROR_FOUND;
+
+    /* Move the last item to the freed slot, from where it may 
+       have to go either up or down */
+    struct heap_entry last = heap->entries[--heap->length];
+
+    if(i == heap->length)
+        return NO_ERROR;
+
+    if(i > 0 && heap_before(&last, &heap->entries[(i - 1) / HEAP_ARITY]))
+        heap_sift_up(heap, i, last);
+    else
+        heap_sift_down(heap, i, last);
+
+    return NO_ERROR;
+}
+
+int heap_peek_key(heap_t heap, uint64_t *key)
+{
+    if(heap == NULL || key == NULL || heap->length == 0)
+        return ERROR_FOUND;
+
+    *key = heap->entries[0].key;
+
+    return NO_ERROR;
+}
+
+size_t heap_length(heap_t heap)
+{
+    if(heap == NULL)
+        return 0;
+
+    return heap->length;
+}
@@ -0,0 +1,106 @@
+#ifndef _HEAP_H
+#define _HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * heap_t - Heap type
+ *
+ * A heap is a priority queue: each data item is pushed with a key, and pops
+ * return the item of smallest key first. Items of equal keys are popped in
+ * the order they were pushed. The heap is d-ary, each node having
+ * HEAP_ARITY children, which makes it shallower than a binary heap and keeps
+ * the children of a node in one cache line.
+ *
+ * Push and pop are O(log n), pushes being amortized, and the other operations
+ * are O(1).
+ */
+typedef struct heap* heap_t;
+
+/* Number of children of each node of a heap */
+#define HEAP_ARITY 4
+
+/*
+ * heap_create - Allocate an empty heap
+ *
+ * Return: Pointer to new empty heap. NULL in case of failure when allocating
+ * the new heap.
+ */
+heap_t heap_create(void);
+
+/*
+ * heap_destroy - Deallocate a heap
+ * @heap: Heap to deallocate
+ *
+ * Deallocate the memory associated to the heap object pointed by @heap. The
+ * items still in the heap, if any, are dropped.
+ *
+ * Return: -1 if @heap is NULL. 0 if @heap was successfully destroyed.
+ */
+int heap_destroy(heap_t heap);
+
+/*
+ * heap_reserve - Make room for items in a heap
+ * @heap: Heap in which to make room
+ * @count: Number of items about to be pushed
+ *
+ * Grow @heap ahead of time, so that the next @count pushes cannot fail.
+ *
+ * Return: -1 if @heap is NULL, or in case of memory allocation error. 0 if
+ * @heap has room for @count more items.
+ */
+int heap_reserve(heap_t heap, size_t count);
+
+/*
+ * heap_push - Push an item in a heap
+ * @heap: Heap in which to push the item
+ * @key: Key of the item, the smallest key being popped first
+ * @data: Address of data item to push
+ *
+ * Return: -1 if @heap or @data are NULL, or in case of memory allocation error
+ * when growing @heap. 0 if @data was successfully pushed in @heap.
+ */
+int heap_push(heap_t heap, uint64_t key, void *data);
+
+/*
+ * heap_pop - Pop the item of smallest key of a heap
+ * @heap: Heap from which to pop the item
+ * @data: Address of data pointer where item is received
+ *
+ * Return: -1 if @heap or @data are NULL, or if @heap is empty. 0 if @data was
+ * set with the item of smallest key of @heap.
+ */
+int heap_pop(heap_t heap, void **data);
+
+/*
+ * heap_remove - Remove an item from a heap
+ * @heap: Heap from which to remove the item
+ * @data: Item to remove
+ *
+ * Unlike the other operations, this is O(n), as the item has to be looked up.
+ *
+ * Return: -1 if @heap or @data are NULL, or if @data is not in @heap. 0 if
+ * @data was successfully removed from @heap.
+ */
+int heap_remove(heap_t heap, void *data);
+
+/*
+ * heap_peek_key - Get the smallest key of a heap
+ * @heap: Heap to look into
+ * @key: Address where the key is received
+ *
+ * Return: -1 if @heap or @key are NULL, or if @heap is empty. 0 if @key was set
+ * with the key of the item heap_pop() would return.
+ */
+int heap_peek_key(heap_t heap, uint64_t *key);
+
+/*
+ * heap_length - Heap length
+ * @heap: Heap to get the length of
+ *
+ * Return: Number of items in @heap, 0 if @heap is NULL.
+ */
+size_t heap_length(heap_t heap);
+
+#endif /* _HEAP_H */
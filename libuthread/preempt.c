@@ -1,40 +1,63 @@
 #include <signal.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "private.h"
 #include "uthread.h"
 
 /*
- * Frequency of preemption
- * 10 * HZ ms = 1000 ms = 0.01s 
+ * Default time slice of preemption, in us of CPU time
+ * 1000 us = 1 ms, hence 1000 SIGVTALRM per second of CPU
  */
-#define HZ 100
+#define PREEMPT_QUANTUM_US 1000
+
+/* Older C libraries only know the field under its kernel name */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
 
 /* 
- * timer -- non user level data struct 
+ * preempt_timer -- non user level POSIX timer
  * 
- * This data struct is designed to use along with
- * a signal handler. It will send a SIGVTARLM signal 
- * to the system per 0.01s, which is 1000 ms. Hence, 
- * 100 SIGVTARLM singal will be sent with in 1 second.
+ * This timer measures the CPU time of the kernel thread
+ * which started the library, the worker running all the
+ * threads, and sends a SIGVTARLM signal to that very 
+ * kernel thread (SIGEV_THREAD_ID) every quantum. Other
+ * kernel threads of the process, if any, neither count
+ * towards the quantum nor get interrupted.
  * 
  * Implementation of such data struct allows RR
  * (Robin-Round) scheduling, In RR scheduling, all
- * threads will be given a fixed amount of time, which
- * is 1000ms here. Such scheduling prevents thread from
+ * threads will be given a fixed amount of time, the
+ * quantum. Such scheduling prevents thread from
  * holding the resources for too long, while at the same
  * time decreasing average waiting time for the thread.  
  * 
- * When the timer is set to stop, its it_value and 
- * it_interval will be set to zero
+ * preempt_timer_created tells whether the timer could
+ * be created and armed. Otherwise, the process-wide
+ * virtual interval timer is used instead, through
+ * timer.
  */
+timer_t preempt_timer;
+bool preempt_timer_created;
 struct itimerval timer;
 
+/*
+ * preempt_worker -- non user level per kernel thread flag
+ * 
+ * Set on the kernel thread running the threads of the
+ * library, which is the only one a tick may preempt.
+ */
+_Thread_local bool preempt_worker;
+
 /* 
  * signal_handler -- non user level data struct 
  * 
@@ -59,8 +82,32 @@ struct itimerval timer;
  */
 struct sigaction signal_handler; 
 
+/*
+ * Soft preemption -- non user level state
+ *
+ * preempt_soft     : preemption is disabled by a flag, 
+ *                    rather than by masking SIGVTALRM
+ *
+ * preempt_disabled : the flag, checked by the handler
+ *
+ * preempt_pending  : a tick was received while the flag
+ *                    was set, preempt_enable() yields
+ */
+bool preempt_soft;
+volatile sig_atomic_t preempt_disabled;
+volatile sig_atomic_t preempt_pending;
+
 void preempt_disable(void)
 {
+    if(preempt_soft) {
+        preempt_disabled = 1;
+
+        /* Keep the critical section after the flag */
+        atomic_signal_fence(memory_order_seq_cst);
+        return;
+    }
+
+
     /* Block SIGVTALRM in Signal Handler*/
     sigemptyset(&signal_handler.sa_mask);
     sigaddset(&signal_handler.sa_mask, SIGVTALRM);
@@ -72,6 +119,19 @@ void preempt_disable(void)
 
 void preempt_enable(void)
 {
+    if(preempt_soft) {
+        /* Keep the critical section before the flag */
+        atomic_signal_fence(memory_order_seq_cst);
+        preempt_disabled = 0;
+
+        /* Take the tick received in the critical section */
+        if(preempt_pending) {
+            preempt_pending = 0;
+            uthread_preempt();
+        }
+        return;
+    }
+
     /* Unblock SIGVTALRM in Signal Handler*/
     sigemptyset(&signal_handler.sa_mask);
     sigaddset(&signal_handler.sa_mask, SIGVTALRM);
@@ -83,15 +143,77 @@ void preempt_enable(void)
 
 void response_handler() 
 {
+    /* Only the worker runs threads, a tick landing on another 
+       kernel thread (e.g., from the virtual interval timer) 
+       has nothing to preempt */
+    if(!preempt_worker)
+        return;
+
+    /* Postpone the tick if in a critical section */
+    if(preempt_soft && preempt_disabled) {
+        preempt_pending = 1;
+        return;
+    }
+
     /* When receive signal move to next tcb */
-    uthread_yield();
+    uthread_preempt();
 }
 
-void preempt_start(void)
+/*
+ * preempt_timer_start - Start ticking every quantum
+ * @quantum_us: Time slice, in us of CPU time
+ */
+static void preempt_timer_start(unsigned quantum_us)
 {
+    struct sigevent event = { 0 };
+    struct itimerspec spec;
+
+    /* Tick on the calling kernel thread alone */
+    event.sigev_notify           = SIGEV_THREAD_ID;
+    event.sigev_signo            = SIGVTALRM;
+    event.sigev_notify_thread_id = syscall(SYS_gettid);
+
+    preempt_timer_created = 
+        timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &preempt_timer) == 0;
+
+    if(preempt_timer_created) {
+        spec.it_interval.tv_sec  = quantum_us / 1000000;
+        spec.it_interval.tv_nsec = quantum_us % 1000000 * 1000;
+        spec.it_value            = spec.it_interval;
+        if(timer_settime(preempt_timer, 0, &spec, NULL) == 0)
+            return;
+
+        timer_delete(preempt_timer);
+        preempt_timer_created = false;
+    }
+
+    /* Fall back on the process-wide virtual interval timer, if 
+       the per-thread timer could not be created or armed */
+    timer.it_interval.tv_sec  = quantum_us / 1000000;
+    timer.it_interval.tv_usec = quantum_us % 1000000;
+    timer.it_value            = timer.it_interval;
+    setitimer(ITIMER_VIRTUAL, &timer, NULL);
+}
+
+void preempt_start(int soft, unsigned quantum_us)
+{
+    preempt_worker   = true;
+    preempt_soft     = soft;
+    preempt_disabled = 0;
+    preempt_pending  = 0;
+
     /* Setting the block Signal to be SIGVTALRM */
     sigemptyset(&signal_handler.sa_mask);
     sigaddset(&signal_handler.sa_mask, SIGVTALRM);
+    signal_handler.sa_flags = 0;
+
+    /* With soft preemption, the handler may switch to another 
+       thread without ever returning, and nothing would unmask 
+       SIGVTALRM then: leave it unmasked while handling it */
+    if(soft) {
+        sigemptyset(&signal_handler.sa_mask);
+        signal_handler.sa_flags = SA_NODEFER;
+    }
 
     /* When being interrupted, execute response_handler() */
     signal_handler.sa_handler = &response_handler;
@@ -100,11 +222,7 @@ void preempt_start(void)
     sigaction(SIGVTALRM, &signal_handler, NULL);
 
     /* Create the Timer */
-    timer.it_interval.tv_sec  = 0;
-    timer.it_interval.tv_usec = 10 * HZ;
-    timer.it_value.tv_sec     = 0;
-    timer.it_value.tv_usec    = 10 * HZ;
-    setitimer(ITIMER_VIRTUAL, &timer, NULL);
+    preempt_timer_start(quantum_us ? quantum_us : PREEMPT_QUANTUM_US);
 }
 
 void preempt_stop(void)
@@ -112,8 +230,14 @@ void preempt_stop(void)
     /* A timer which is set to zero (it_value is zero or
        the timer expires and it_interval is zero) stops. 
        https://linux.die.net/man/2/setitimer */
-    timer.it_interval.tv_usec = 0;
-    timer.it_value.tv_usec    = 0;
+    if(preempt_timer_created) {
+        timer_delete(preempt_timer);
+        preempt_timer_created = false;
+    } else {
+        timerclear(&timer.it_interval);
+        timerclear(&timer.it_value);
+        setitimer(ITIMER_VIRTUAL, &timer, NULL);
+    }
 
     /* sa_handler specifies the action to be associated 
        with signum and may be SIG_DFL for the default action,
@@ -122,4 +246,7 @@ void preempt_stop(void)
        https://man7.org/linux/man-pages/man2/sigaction.2.html */
     signal_handler.sa_handler = SIG_IGN;
     sigaction(SIGVTALRM, &signal_handler, NULL);
+
+    preempt_soft   = false;
+    preempt_worker = false;
 }
@@ -10,6 +10,9 @@
 /**
  * Private context API
  */
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <ucontext.h>
 
 
@@ -17,6 +20,25 @@
 
 /*
  * uthread_ctx_t - User-level thread context
+ * @uc: Saved execution context
+ * @stack_guard: End of the guard page of a growable stack, ie lowest address
+ *	the stack may ever grow to
+ * @stack_committed: Lowest committed address of a growable stack, NULL if the
+ *	stack is not growable
+ * @shared: Whether the context runs on the shared stack
+ * @started: Whether a context on the shared stack was run at least once
+ * @func: Function to be executed by a context on the shared stack, which is
+ *	only set up when first run
+ * @arg: Argument to pass to @func
+ * @stack_sp: Lowest address of the shared stack in use by the context when it
+ *	was last switched out
+ * @saved: Copy of the used part of the shared stack, while another context
+ *	runs on it
+ * @saved_size: Size of the copy in @saved
+ * @saved_capacity: Allocated size of @saved
+ * @jb: Registers saved when switched out with the signal mask treated as
+ *	process-wide
+ * @resumable: Whether @jb holds the context, rather than @uc
  *
  * This type is an opaque data structure type that contains a thread's execution
  * context.
@@ -25,7 +47,23 @@
  * uthread_ctx_init(). Once initialized, it can be switched to with
  * uthread_ctx_switch().
  */
-typedef ucontext_t uthread_ctx_t;
+typedef struct uthread_ctx {
+	ucontext_t uc;
+	char *stack_guard;
+	char *stack_committed;
+
+	int shared;
+	int started;
+	uthread_func_t func;
+	void *arg;
+	char *stack_sp;
+	char *saved;
+	size_t saved_size;
+	size_t saved_capacity;
+
+	jmp_buf jb;
+	int resumable;
+} uthread_ctx_t;
 
 /*
  * uthread_ctx_switch - Switch between two execution contexts
@@ -35,33 +73,86 @@ typedef ucontext_t uthread_ctx_t;
  */
 void uthread_ctx_switch(uthread_ctx_t *prev, uthread_ctx_t *next);
 
+/*
+ * uthread_ctx_shared_sigmask - Select how switches handle the signal mask
+ * @enable: Whether the signal mask is process-wide
+ *
+ * By default, every context has its own signal mask, saved and restored by
+ * each switch at the cost of a system call. Once the signal mask is treated as
+ * process-wide, switches leave it alone, except when a context is run for the
+ * first time.
+ */
+void uthread_ctx_shared_sigmask(int enable);
+
+/*
+ * uthread_ctx_release - Release the resources held by a context
+ * @uctx: Context of a thread which exited
+ */
+void uthread_ctx_release(uthread_ctx_t *uctx);
+
 /*
  * uthread_ctx_alloc_stack - Allocate stack segment
+ * @stack_size: Size of the stack segment, in bytes
+ * @stack_mode: How the stack segment is backed by memory
+ *
+ * A growable stack segment is only reserved: apart from its topmost pages, it
+ * gets committed as the stack grows into it. A shared stack segment is the
+ * same for every thread, and @stack_size is ignored.
  *
  * Return: Pointer to the top of a valid stack segment, or NULL in case of
  * failure
  */
-void *uthread_ctx_alloc_stack(void);
+void *uthread_ctx_alloc_stack(size_t stack_size,
+			      enum uthread_stack_mode stack_mode);
 
 /*
  * uthread_ctx_destroy_stack - Deallocate stack segment
  * @top_of_stack: Address of stack to deallocate
+ * @stack_size: Size of the stack segment, as given to
+ *	uthread_ctx_alloc_stack()
+ * @stack_mode: Mode of the stack segment, as given to
+ *	uthread_ctx_alloc_stack()
  */
-void uthread_ctx_destroy_stack(void *top_of_stack);
+void uthread_ctx_destroy_stack(void *top_of_stack, size_t stack_size,
+			       enum uthread_stack_mode stack_mode);
 
 /*
  * uthread_ctx_init - Initialize a thread's execution context
  * @uctx: Pointer to thread context to initialize
  * @top_of_stack: Pointer to the top of a valid stack segment, as allocated by
  *	uthread_ctx_alloc_stack()
+ * @stack_size: Size of the stack segment, as given to
+ *	uthread_ctx_alloc_stack()
+ * @stack_mode: Mode of the stack segment, as given to
+ *	uthread_ctx_alloc_stack()
  * @func: Function to be executed by the thread
  * @arg: Argument to pass to the thread
  *
  * Return: 0 if @uctx was properly initialized, or -1 in case of failure
  */
 int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
+		     size_t stack_size, enum uthread_stack_mode stack_mode,
 		     uthread_func_t func, void *arg);
 
+/*
+ * uthread_ctx_init_from - Initialize a thread's execution context from another
+ * @uctx: Pointer to thread context to initialize
+ * @model: Context already initialized by uthread_ctx_init() on a fixed stack
+ * @top_of_stack: Pointer to the top of a fixed stack segment
+ * @stack_size: Size of the stack segment
+ * @func: Function to be executed by the thread
+ * @arg: Argument to pass to the thread
+ *
+ * Same as uthread_ctx_init() for a fixed stack, except that the execution
+ * context is copied from @model instead of being captured by getcontext(),
+ * which saves a system call. The copy is only valid if the machine context
+ * holds no pointer into @model. On x86, the pointer to the FP state is
+ * rebased onto the copy. Architectures whose machine context points into
+ * itself in other ways, such as powerpc, are not supported.
+ */
+void uthread_ctx_init_from(uthread_ctx_t *uctx, const uthread_ctx_t *model,
+			   void *top_of_stack, size_t stack_size,
+			   uthread_func_t func, void *arg);
 
 /**
  * Private preemption API
@@ -69,11 +160,20 @@ int uthread_ctx_init(uthread_ctx_t *uctx, void *top_of_stack,
 
 /*
  * preempt_start - Start thread preemption
+ * @soft: Whether preemption is disabled by a flag rather than by masking the
+ *	virtual alarm signal
+ * @quantum_us: Time slice of a thread, in microseconds of CPU time, or 0 for
+ *	the default of 1 ms
+ *
+ * Configure a timer that must fire a virtual alarm every @quantum_us of CPU
+ * time of the calling kernel thread, to that kernel thread only, and setup a
+ * timer handler that forcefully yields the thread it is running.
  *
- * Configure a timer that must fire a virtual alarm at a frequency of 100 Hz and
- * setup a timer handler that forcefully yields the currently running thread.
+ * With @soft, preempt_disable() and preempt_enable() do not make any system
+ * call: a tick received while preemption is disabled is only recorded, and the
+ * thread yields once preemption is enabled again.
  */
-void preempt_start(void);
+void preempt_start(int soft, unsigned quantum_us);
 
 /*
  * preempt_stop - Stop thread preemption
@@ -111,6 +211,14 @@ struct uthread_tcb;
  */
 struct uthread_tcb *uthread_current(void);
 
+/*
+ * uthread_runnable - Whether a thread is ready or running
+ * @uthread: TCB of the thread
+ *
+ * Return: false if @uthread is blocked or exited
+ */
+bool uthread_runnable(struct uthread_tcb *uthread);
+
 /*
  * uthread_block - Block currently running thread
  */
@@ -122,4 +230,140 @@ void uthread_block(void);
  */
 void uthread_unblock(struct uthread_tcb *uthread);
 
+/*
+ * uthread_waiter - Wait record of a thread
+ * @thread: The thread itself
+ * @wait_start: Time at which the thread blocked, in microseconds, for the
+ *	statistics of the wait list
+ * @next: Next waiter in the wait list the thread is blocked in
+ *
+ * A wait list chains the wait records of its blocked threads, so that
+ * blocking never allocates memory. The record is part of the TCB rather than
+ * of the stack of the blocked thread: a thread on the shared stack has its
+ * frames copied out, and their addresses reused, while it does not run. A
+ * thread is in at most one wait list at a time.
+ */
+struct uthread_waiter {
+	struct uthread_tcb *thread;
+	uint64_t wait_start;
+	struct uthread_waiter *next;
+};
+
+/*
+ * uthread_waiter - Get the wait record of a thread
+ * @uthread: TCB of the thread
+ */
+struct uthread_waiter *uthread_waiter(struct uthread_tcb *uthread);
+
+/*
+ * uthread_preempt - Forcefully yield currently running thread
+ *
+ * Same as uthread_yield(), except that the switch is accounted as involuntary
+ * in the thread statistics. Meant to be called by the preemption handler.
+ */
+void uthread_preempt(void);
+
+
+/**
+ * Private scheduler API
+ */
+
+/* Deadline of a thread which did not declare any */
+#define UTHREAD_NO_DEADLINE UINT64_MAX
+
+/*
+ * uthread_sched_entity - Scheduling state of a thread
+ * @deadline: Absolute deadline of the current activation of the thread, in
+ *	nanoseconds, or UTHREAD_NO_DEADLINE
+ * @relative_deadline: Relative deadline of each activation, 0 for none
+ * @vruntime: Virtual runtime, for policies which account CPU time
+ * @ticket: Position in the ready set, for policies which index it instead
+ * @priority: Priority given at creation
+ *
+ * The library keeps @deadline, @relative_deadline and @priority up to date,
+ * @vruntime or @ticket belongs to the policy. The entity is the first member
+ * of the TCB, so that it shares the TCB's first cache line with the fields
+ * scheduling reads.
+ */
+struct uthread_sched_entity {
+	uint64_t deadline;
+	uint64_t relative_deadline;
+	union {
+		uint64_t vruntime;
+		size_t ticket;
+	};
+	int priority;
+};
+
+/*
+ * uthread_sched_entity - Get the scheduling state of a thread
+ * @tcb: TCB of the thread
+ */
+static inline struct uthread_sched_entity *
+uthread_sched_entity(struct uthread_tcb *tcb)
+{
+	return (struct uthread_sched_entity *) tcb;
+}
+
+/*
+ * uthread_sched_ops - Scheduling policy
+ * @name: Name of the policy
+ * @init: Set up the ready set, when the library starts. Return -1 in case of
+ *	failure, 0 otherwise.
+ * @fini: Release the ready set, when the library stops
+ * @reserve: Make room for @count more ready threads, so that @enqueue cannot
+ *	fail. Return -1 in case of failure, 0 otherwise.
+ * @enqueue: Add a thread to the ready set. A yielding thread is enqueued
+ *	right after @pick_next, so it can take the room just freed.
+ * @enqueue_batch: Add @count threads to the ready set, in the order of
+ *	@tcbs, as one operation. Optional, @enqueue is called for each thread
+ *	if NULL.
+ * @pick_next: Take the next thread to run out of the ready set, NULL if none
+ * @nr_ready: Number of threads in the ready set
+ * @charge: Account @ran_ns of CPU time to the running thread, before any
+ *	decision involving it is made. Optional.
+ * @on_create: A thread was created, and is about to be enqueued. Optional.
+ * @on_block: The running thread is about to block. Optional.
+ * @on_wake: A blocked thread was woken up, and is about to be enqueued.
+ *	Optional.
+ * @on_tick: Whether the running thread keeps the CPU, although a thread is
+ *	ready, when it receives a preemption tick (@involuntary) or yields.
+ *	Optional, the running thread always gives way if NULL.
+ * @check_preempt: Whether @tcb, just made ready, must preempt the running
+ *	thread right away. Optional, threads made ready never preempt if NULL.
+ * @check_deadline: Whether a ready thread must preempt the running thread
+ *	right away, now that the deadline of the running thread changed.
+ *	Optional, changing a deadline never preempts if NULL.
+ * @yield_to: Take the ready thread @tcb out of the ready set, and add the
+ *	running thread @curr to it, as @curr directly yields to @tcb. Return -1
+ *	if @tcb is not in the ready set, 0 otherwise. Optional, directed yields
+ *	fail if NULL.
+ *
+ * All the operations are called with preemption disabled. A policy is picked
+ * at start with the policy or sched runtime options.
+ */
+struct uthread_sched_ops {
+	const char *name;
+	int (*init)(void);
+	void (*fini)(void);
+	int (*reserve)(size_t count);
+	void (*enqueue)(struct uthread_tcb *tcb);
+	void (*enqueue_batch)(struct uthread_tcb *const tcbs[], size_t count);
+	struct uthread_tcb *(*pick_next)(void);
+	size_t (*nr_ready)(void);
+	void (*charge)(struct uthread_tcb *curr, uint64_t ran_ns);
+	void (*on_create)(struct uthread_tcb *tcb);
+	void (*on_block)(struct uthread_tcb *curr);
+	void (*on_wake)(struct uthread_tcb *tcb);
+	bool (*on_tick)(struct uthread_tcb *curr, bool involuntary);
+	bool (*check_preempt)(struct uthread_tcb *curr, struct uthread_tcb *tcb);
+	bool (*check_deadline)(struct uthread_tcb *curr);
+	int (*yield_to)(struct uthread_tcb *curr, struct uthread_tcb *tcb);
+};
+
+/* Built-in policies, see enum uthread_sched_policy */
+extern const struct uthread_sched_ops uthread_sched_fifo;
+extern const struct uthread_sched_ops uthread_sched_edf;
+extern const struct uthread_sched_ops uthread_sched_fair;
+
 #endif /* _UTHREAD_PRIVATE_H */
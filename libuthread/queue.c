@@ -1,3 +1,4 @@
+#include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -62,18 +63,21 @@ queue_t queue_create(void)
  * queue_destroy - Deallocate a queue
  * @queue: Queue to deallocate
  *
- * Deallocate the memory associated to the queue object pointed by @queue.
+ * Deallocate the memory associated to the queue object pointed by @queue,
+ * including the nodes of the items still enqueued, if any.
  *
- * Return: -1 if @queue is NULL or if @queue is not empty. 0 if @queue was
- * successfully destroyed.
+ * Return: -1 if @queue is NULL. 0 if @queue was successfully destroyed.
  */
 int queue_destroy(queue_t queue)
 {
-    if(queue == NULL || queue->num_of_nodes == 0)
+    if(queue == NULL)
         return ERROR_FOUND;
 
     queue_node *node_to_destroy = queue->first_in_queue;
-    queue_node *next_node = node_to_destroy->next_in_queue;
+    queue_node *next_node = NULL;
+
+    if(node_to_destroy != NULL)
+        next_node = node_to_destroy->next_in_queue;
 
     /* Free queue_node inside the queue */
     while(queue->num_of_nodes > 0) {
@@ -109,13 +113,34 @@ int queue_destroy(queue_t queue)
  */
 int queue_enqueue(queue_t queue, void *data)
 {
+    if(queue_enqueue_handle(queue, data) == NULL)
+        return ERROR_FOUND;
+
+    return NO_ERROR;
+}
+
+/*
+ * queue_enqueue_handle - Enqueue data item and get its handle
+ * @queue: Queue in which to enqueue item
+ * @data: Address of data item to enqueue
+ *
+ * Same as queue_enqueue(), but return the node holding @data, so that it
+ * can later be removed with queue_remove_handle().
+ *
+ * Return: NULL if @queue or @data are NULL, or in case of memory allocation
+ * error when enqueing. Handle of the enqueued item otherwise.
+ */
+queue_handle_t queue_enqueue_handle(queue_t queue, void *data)
+{
+    /* Check for problems with data and passed queue */
+    if(queue == NULL || data == NULL)
+        return NULL;
+
     queue_node *node_to_enqueue = malloc(sizeof(queue_node));
 
-    /* Check for problems with data, memory allocation, and passed queue */
-    if(node_to_enqueue == NULL || queue == NULL || data == NULL)
-    {
-        return ERROR_FOUND;
-    }
+    /* Check for problems with memory allocation */
+    if(node_to_enqueue == NULL)
+        return NULL;
 
     /* If no problem exists with data, memory allocation, and passed queue, proceed*/
     node_to_enqueue->data_in_node = data;
@@ -143,7 +168,32 @@ int queue_enqueue(queue_t queue, void *data)
     /* Regardless of whether it is the first node in the queue or not, a new node has been added */
     queue->num_of_nodes += ONE_NODE;
 
-    return NO_ERROR;
+    return node_to_enqueue;
+}
+
+/*
+ * queue_unlink - Unlink a node from a queue and free it
+ * @queue: Queue holding the node
+ * @node: Node to unlink
+ *
+ * Uses the links of @node only, so it is O(1) wherever @node is.
+ */
+static void queue_unlink(queue_t queue, queue_node *node)
+{
+    /* Next node in the queue's previous node is now node's previous node */
+    if(node->next_in_queue != NULL)
+        node->next_in_queue->prev_in_queue = node->prev_in_queue;
+    else
+        queue->last_in_queue = node->prev_in_queue;
+
+    /* Prev node in the queue's next node is now node's next node */
+    if(node->prev_in_queue != NULL)
+        node->prev_in_queue->next_in_queue = node->next_in_queue;
+    else
+        queue->first_in_queue = node->next_in_queue;
+
+    queue->num_of_nodes -= ONE_NODE;
+    free(node);
 }
 
 /*
@@ -170,9 +220,7 @@ int queue_dequeue(queue_t queue, void **data)
     *data = node_to_dequeue->data_in_node;
 
     /* Reassign the front of the queue to the next in line */
-    queue->first_in_queue = node_to_dequeue->next_in_queue;
-
-    queue->num_of_nodes -= ONE_NODE;
+    queue_unlink(queue, node_to_dequeue);
 
     return NO_ERROR;
 }
@@ -205,57 +253,139 @@ int queue_delete(queue_t queue, void *data)
             continue;
         }
 
-        else if(index_node->data_in_node == data)
-        {
-            /* First node in the queue */
-            if(index_node->next_in_queue != NULL && index_node->prev_in_queue == NULL)
-            {
-                queue_node *new_front_node = index_node->next_in_queue;
-                new_front_node->prev_in_queue = NULL;
-
-                queue->first_in_queue = new_front_node;
-            }
-
-            /* Middle node in the queue */
-            else if(index_node->next_in_queue != NULL && index_node->prev_in_queue != NULL)
-            {
-                queue_node *temp_for_next_node = index_node->next_in_queue;
-                queue_node *temp_for_prev_node = index_node->prev_in_queue;
-
-                /* Cut out the index node from the queue with the below two operations 
-                   Next node in the queue's previous node is now index's previous node */
-                temp_for_next_node->prev_in_queue = index_node->prev_in_queue;
-
-                /* Prev node in the queue's next node is now index's next node */
-                temp_for_prev_node->next_in_queue = index_node->next_in_queue;
-            }
-
-            /* Last node in the queue */
-            else if(index_node->next_in_queue == NULL && index_node->prev_in_queue != NULL)
-            {
-                queue_node *new_last_node = index_node->prev_in_queue;
-                new_last_node->next_in_queue = NULL;
-
-                queue->last_in_queue = new_last_node;
-            }
-
-            /* Only node exists in the queue */
-            else
-            {
-                queue->first_in_queue = NULL;
-                queue->last_in_queue = NULL;
-            }
-
-            /* @data was found so we always remove a node and now we can return */
-            queue->num_of_nodes -= ONE_NODE;
-            return NO_ERROR;
-        }
+        /* @data was found so we always remove a node and now we can return */
+        queue_unlink(queue, index_node);
+        return NO_ERROR;
     }
 
     /* @data was not found */
     return ERROR_FOUND;
 }
 
+/*
+ * queue_remove_handle - Remove an item by its handle
+ * @queue: Queue in which to remove item
+ * @handle: Handle returned by queue_enqueue_handle() when the item was
+ *          enqueued in @queue
+ *
+ * Unlike queue_delete(), no search is needed: the item is unlinked in O(1).
+ * @handle must still be in @queue, ie its item was neither dequeued nor
+ * deleted, and it is no longer valid once removed.
+ *
+ * Return: -1 if @queue or @handle are NULL. 0 if the item was removed from
+ * @queue.
+ */
+int queue_remove_handle(queue_t queue, queue_handle_t handle)
+{
+    if(queue == NULL || handle == NULL)
+        return ERROR_FOUND;
+
+    queue_unlink(queue, handle);
+
+    return NO_ERROR;
+}
+
+/*
+ * queue_splice - Move all the items of a queue to the back of another
+ * @dst: Queue to append the items to
+ * @src: Queue to take the items from
+ *
+ * The nodes of @src are linked after the last node of @dst as a whole, so
+ * this is O(1) whatever the number of items. @src is left empty.
+ *
+ * Return: -1 if @dst or @src are NULL, or if they are the same queue. 0 if
+ * the items of @src were moved to @dst.
+ */
+int queue_splice(queue_t dst, queue_t src)
+{
+    if(dst == NULL || src == NULL || dst == src)
+        return ERROR_FOUND;
+
+    /* Nothing to move */
+    if(src->num_of_nodes == 0)
+        return NO_ERROR;
+
+    /* Link the first node of @src after the last node of @dst */
+    if(dst->num_of_nodes == 0)
+        dst->first_in_queue = src->first_in_queue;
+    else
+    {
+        dst->last_in_queue->next_in_queue = src->first_in_queue;
+        src->first_in_queue->prev_in_queue = dst->last_in_queue;
+    }
+
+    dst->last_in_queue = src->last_in_queue;
+    dst->num_of_nodes += src->num_of_nodes;
+
+    src->first_in_queue = NULL;
+    src->last_in_queue  = NULL;
+    src->num_of_nodes   = 0;
+
+    return NO_ERROR;
+}
+
+/*
+ * queue_enqueue_batch - Enqueue several data items
+ * @queue: Queue in which to enqueue the items
+ * @items: Addresses of the data items to enqueue
+ * @n: Number of items in @items
+ *
+ * Enqueue the items of @items in order, as many calls to queue_enqueue()
+ * would, except that either all of them or none of them are enqueued.
+ *
+ * Return: -1 if @queue is NULL, if @items is NULL while @n is not 0, if one of
+ * the items is NULL, or in case of memory allocation error, in which case
+ * @queue is left untouched. 0 if all the items were enqueued in @queue.
+ */
+int queue_enqueue_batch(queue_t queue, void *const items[], size_t n)
+{
+    if(queue == NULL || (items == NULL && n > 0))
+        return ERROR_FOUND;
+
+    /* Build the chain of nodes aside, so that @queue is only touched once
+       all of them were allocated */
+    struct queue batch = { NULL, NULL, 0 };
+
+    for(size_t i = 0; i < n; i++)
+    {
+        if(queue_enqueue_handle(&batch, items[i]) == NULL)
+        {
+            void *data;
+
+            while(queue_dequeue(&batch, &data) == NO_ERROR)
+                ;
+            return ERROR_FOUND;
+        }
+    }
+
+    return queue_splice(queue, &batch);
+}
+
+/*
+ * queue_drain - Dequeue several data items
+ * @queue: Queue in which to dequeue the items
+ * @out: Array where the items are received
+ * @max: Maximum number of items to dequeue, ie the size of @out
+ *
+ * Remove the oldest items of @queue, up to @max of them, and assign them to
+ * @out from the oldest one.
+ *
+ * Return: -1 if @queue is NULL, or if @out is NULL while @max is not 0.
+ * Number of items dequeued otherwise, 0 if @queue was empty.
+ */
+int queue_drain(queue_t queue, void *out[], size_t max)
+{
+    if(queue == NULL || (out == NULL && max > 0))
+        return ERROR_FOUND;
+
+    size_t count = 0;
+
+    while(count < max && queue->num_of_nodes > 0)
+        queue_dequeue(queue, &out[count++]);
+
+    return count;
+}
+
 /*
  * queue_iterate - Iterate through a queue
  * @queue: Queue to iterate through
@@ -279,13 +409,11 @@ int queue_iterate(queue_t queue, queue_func_t func)
 
     while(index_node != NULL)
     {
-        func(index_node->data_in_node);
+        // Interruption Protection, @func may delete the current item
+        queue_node *next_node = index_node->next_in_queue;
 
-        // Interruption Protection
-        if(index_node->next_in_queue != NULL)
-            index_node = index_node->next_in_queue;
-        else
-            break;
+        func(index_node->data_in_node);
+        index_node = next_node;
     }
 
     return NO_ERROR;
@@ -1,6 +1,8 @@
 #ifndef _QUEUE_H
 #define _QUEUE_H
 
+#include <stddef.h>
+
 /*
  * queue_t - Queue type
  *
@@ -12,6 +14,14 @@
  */
 typedef struct queue* queue_t;
 
+/*
+ * queue_handle_t - Queue item handle
+ *
+ * Designates one enqueued item, so that it can be removed without searching
+ * the queue for it.
+ */
+typedef struct queue_node* queue_handle_t;
+
 /*
  * queue_create - Allocate an empty queue
  *
@@ -26,10 +36,10 @@ queue_t queue_create(void);
  * queue_destroy - Deallocate a queue
  * @queue: Queue to deallocate
  *
- * Deallocate the memory associated to the queue object pointed by @queue.
+ * Deallocate the memory associated to the queue object pointed by @queue,
+ * including the nodes of the items still enqueued, if any.
  *
- * Return: -1 if @queue is NULL or if @queue is not empty. 0 if @queue was
- * successfully destroyed.
+ * Return: -1 if @queue is NULL. 0 if @queue was successfully destroyed.
  */
 int queue_destroy(queue_t queue);
 
@@ -45,6 +55,19 @@ int queue_destroy(queue_t queue);
  */
 int queue_enqueue(queue_t queue, void *data);
 
+/*
+ * queue_enqueue_handle - Enqueue data item and get its handle
+ * @queue: Queue in which to enqueue item
+ * @data: Address of data item to enqueue
+ *
+ * Same as queue_enqueue(), but return the node holding @data, so that it
+ * can later be removed with queue_remove_handle().
+ *
+ * Return: NULL if @queue or @data are NULL, or in case of memory allocation
+ * error when enqueing. Handle of the enqueued item otherwise.
+ */
+queue_handle_t queue_enqueue_handle(queue_t queue, void *data);
+
 /*
  * queue_dequeue - Dequeue data item
  * @queue: Queue in which to dequeue item
@@ -71,6 +94,63 @@ int queue_dequeue(queue_t queue, void **data);
  */
 int queue_delete(queue_t queue, void *data);
 
+/*
+ * queue_remove_handle - Remove an item by its handle
+ * @queue: Queue in which to remove item
+ * @handle: Handle returned by queue_enqueue_handle() when the item was
+ *          enqueued in @queue
+ *
+ * Unlike queue_delete(), no search is needed: the item is unlinked in O(1).
+ * @handle must still be in @queue, ie its item was neither dequeued nor
+ * deleted, and it is no longer valid once removed.
+ *
+ * Return: -1 if @queue or @handle are NULL. 0 if the item was removed from
+ * @queue.
+ */
+int queue_remove_handle(queue_t queue, queue_handle_t handle);
+
+/*
+ * queue_splice - Move all the items of a queue to the back of another
+ * @dst: Queue to append the items to
+ * @src: Queue to take the items from
+ *
+ * The nodes of @src are linked after the last node of @dst as a whole, so
+ * this is O(1) whatever the number of items. @src is left empty.
+ *
+ * Return: -1 if @dst or @src are NULL, or if they are the same queue. 0 if
+ * the items of @src were moved to @dst.
+ */
+int queue_splice(queue_t dst, queue_t src);
+
+/*
+ * queue_enqueue_batch - Enqueue several data items
+ * @queue: Queue in which to enqueue the items
+ * @items: Addresses of the data items to enqueue
+ * @n: Number of items in @items
+ *
+ * Enqueue the items of @items in order, as many calls to queue_enqueue()
+ * would, except that either all of them or none of them are enqueued.
+ *
+ * Return: -1 if @queue is NULL, if @items is NULL while @n is not 0, if one of
+ * the items is NULL, or in case of memory allocation error, in which case
+ * @queue is left untouched. 0 if all the items were enqueued in @queue.
+ */
+int queue_enqueue_batch(queue_t queue, void *const items[], size_t n);
+
+/*
+ * queue_drain - Dequeue several data items
+ * @queue: Queue in which to dequeue the items
+ * @out: Array where the items are received
+ * @max: Maximum number of items to dequeue, ie the size of @out
+ *
+ * Remove the oldest items of @queue, up to @max of them, and assign them to
+ * @out from the oldest one.
+ *
+ * Return: -1 if @queue is NULL, or if @out is NULL while @max is not 0.
+ * Number of items dequeued otherwise, 0 if @queue was empty.
+ */
+int queue_drain(queue_t queue, void *out[], size_t max);
+
 /*
  * queue_func_t - Queue callback function type
  * @data: Data item
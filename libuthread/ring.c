@@ -0,0 +1,174 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring.h"
+
+#define ERROR_FOUND     -1
+#define NO_ERROR         0
+
+/* Capacity of a new ring, a power of two */
+#define RING_MIN_CAPACITY 16
+
+/*
+ * ring - non-user level ring buffer
+ * 
+ * 1. items     : circular array of item pointers
+ * 
+ * 2. capacity  : # of slots in items, a power of two,
+ *                so that indexes wrap around with a mask
+ * 
+ * 3. head      : index of the oldest item, in [0, capacity)
+ * 
+ * 4. length    : # of items in the ring
+ * 
+ * 5. base      : ticket of the oldest item, i.e. # of
+ *                items ever popped
+ */
+typedef struct ring {
+    void **items;
+    size_t capacity;
+    size_t head;
+    size_t length;
+    size_t base;
+} ring;
+
+ring_t ring_create(void)
+{
+    ring_t new_ring = malloc(sizeof(ring));
+
+    if(new_ring == NULL)
+        return NULL;
+
+    new_ring->items = malloc(RING_MIN_CAPACITY * sizeof(void*));
+    if(new_ring->items == NULL) {
+        free(new_ring);
+        return NULL;
+    }
+
+    new_ring->capacity = RING_MIN_CAPACITY;
+    new_ring->head     = 0;
+    new_ring->length   = 0;
+    new_ring->base     = 0;
+
+    return new_ring;
+}
+
+int ring_destroy(ring_t ring)
+{
+    if(ring == NULL)
+        return ERROR_FOUND;
+
+    free(ring->items);
+    free(ring);
+
+    return NO_ERROR;
+}
+
+int ring_reserve(ring_t ring, size_t count)
+{
+    if(ring == NULL)
+        return ERROR_FOUND;
+
+    size_t capacity = ring->capacity;
+
+    while(capacity - ring->length < count)
+        capacity *= 2;
+
+    if(capacity == ring->capacity)
+        return NO_ERROR;
+
+    void **items = malloc(capacity * sizeof(void*));
+    if(items == NULL)
+        return ERROR_FOUND;
+
+    /* Unwrap the items to the start of the new array, in order */
+    size_t first_part = ring->capacity - ring->head;
+
+    if(first_part > ring->length)
+        first_part = ring->length;
+
+    memcpy(items, ring->items + ring->head, first_part * sizeof(void*));
+    memcpy(items + first_part, ring->items,
+           (ring->length - first_part) * sizeof(void*));
+
+    free(ring->items);
+    ring->items    = items;
+    ring->capacity = capacity;
+    ring->head     = 0;
+
+    return NO_ERROR;
+}
+
+int ring_push(ring_t ring, void *data)
+{
+    if(ring == NULL || data == NULL)
+        return ERROR_FOUND;
+
+    if(ring->length == ring->capacity && ring_reserve(ring, 1))
+        return ERROR_FOUND;
+
+    ring->items[(ring->head + ring->length) & (ring->capacity - 1)] = data;
+    ring->length++;
+
+    return NO_ERROR;
+}
+
+int ring_push_batch(ring_t ring, void *const items[], size_t count)
+{
+    if(ring == NULL || items == NULL || ring_reserve(ring, count))
+        return ERROR_FOUND;
+
+    /* The free slots may wrap around the end of the array */
+    size_t tail = (ring->head + ring->length) & (ring->capacity - 1);
+    size_t first_part = ring->capacity - tail;
+
+    if(first_part > count)
+        first_part = count;
+
+    memcpy(ring->items + tail, items, first_part * sizeof(void*));
+    memcpy(ring->items, items + first_part,
+           (count - first_part) * sizeof(void*));
+    ring->length += count;
+
+    return NO_ERROR;
+}
+
+int ring_pop(ring_t ring, void **data)
+{
+    if(ring == NULL || data == NULL || ring->length == 0)
+        return ERROR_FOUND;
+
+    *data = ring->items[ring->head];
+    ring->head = (ring->head + 1) & (ring->capacity - 1);
+    ring->length--;
+    ring->base++;
+
+    return NO_ERROR;
+}
+
+size_t ring_next_ticket(ring_t ring)
+{
+    if(ring == NULL)
+        return 0;
+
+    return ring->base + ring->length;
+}
+
+void **ring_slot(ring_t ring, size_t ticket)
+{
+    /* Tickets wrap around along with base */
+    if(ring == NULL || ticket - ring->base >= ring->length)
+        return NULL;
+
+    return &ring->items[(ring->head + ticket - ring->base) &
+                        (ring->capacity - 1)];
+}
+
+size_t ring_length(ring_t ring)
+{
+    if(ring == NULL)
+        return 0;
+
+    return ring->length;
+}
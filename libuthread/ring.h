@@ -0,0 +1,117 @@
+#ifndef _RING_H
+#define _RING_H
+
+#include <stddef.h>
+
+/*
+ * ring_t - Ring buffer type
+ *
+ * A ring is a FIFO data structure, like a queue, which stores its items in a
+ * circular array rather than in linked nodes. Its capacity is a power of two,
+ * doubled whenever a push finds it full.
+ *
+ * All operations are O(1), pushes being amortized O(1).
+ */
+typedef struct ring* ring_t;
+
+/*
+ * ring_create - Allocate an empty ring
+ *
+ * Return: Pointer to new empty ring. NULL in case of failure when allocating
+ * the new ring.
+ */
+ring_t ring_create(void);
+
+/*
+ * ring_destroy - Deallocate a ring
+ * @ring: Ring to deallocate
+ *
+ * Deallocate the memory associated to the ring object pointed by @ring. The
+ * items still in the ring, if any, are dropped.
+ *
+ * Return: -1 if @ring is NULL. 0 if @ring was successfully destroyed.
+ */
+int ring_destroy(ring_t ring);
+
+/*
+ * ring_reserve - Make room for items in a ring
+ * @ring: Ring in which to make room
+ * @count: Number of items about to be pushed
+ *
+ * Grow @ring ahead of time, so that the next @count pushes cannot fail.
+ *
+ * Return: -1 if @ring is NULL, or in case of memory allocation error. 0 if
+ * @ring has room for @count more items.
+ */
+int ring_reserve(ring_t ring, size_t count);
+
+/*
+ * ring_push - Push an item at the back of a ring
+ * @ring: Ring in which to push the item
+ * @data: Address of data item to push
+ *
+ * Return: -1 if @ring or @data are NULL, or in case of memory allocation error
+ * when growing @ring. 0 if @data was successfully pushed in @ring.
+ */
+int ring_push(ring_t ring, void *data);
+
+/*
+ * ring_push_batch - Push many items at the back of a ring
+ * @ring: Ring in which to push the items
+ * @items: Array of the addresses of the data items to push, none NULL
+ * @count: Number of items in @items
+ *
+ * Same as pushing each item of @items in order, except that @ring is grown
+ * once and the items are copied in at most two pieces. Either all the items
+ * are pushed, or none is.
+ *
+ * Return: -1 if @ring or @items are NULL, or in case of memory allocation
+ * error when growing @ring. 0 if all the items were successfully pushed.
+ */
+int ring_push_batch(ring_t ring, void *const items[], size_t count);
+
+/*
+ * ring_pop - Pop the item at the front of a ring
+ * @ring: Ring from which to pop the item
+ * @data: Address of data pointer where item is received
+ *
+ * Remove the oldest item of @ring and assign this item to @data.
+ *
+ * Return: -1 if @ring or @data are NULL, or if @ring is empty. 0 if @data was
+ * set with the oldest item of @ring.
+ */
+int ring_pop(ring_t ring, void **data);
+
+/*
+ * ring_next_ticket - Ticket of the next item pushed in a ring
+ * @ring: Ring to get the ticket of
+ *
+ * Items are given tickets in the order they are pushed, so that an item still
+ * in the ring can be reached in O(1) with ring_slot().
+ *
+ * Return: Ticket of the next item pushed in @ring, 0 if @ring is NULL.
+ */
+size_t ring_next_ticket(ring_t ring);
+
+/*
+ * ring_slot - Slot of an item of a ring
+ * @ring: Ring to look into
+ * @ticket: Ticket of the item, as given by ring_next_ticket() before its push
+ *
+ * The item may be replaced in place through the returned slot, the new item
+ * taking over its ticket and position.
+ *
+ * Return: Address of the slot holding the item of @ticket, NULL if @ring is
+ * NULL or if the item is no longer in @ring.
+ */
+void **ring_slot(ring_t ring, size_t ticket);
+
+/*
+ * ring_length - Ring length
+ * @ring: Ring to get the length of
+ *
+ * Return: Number of items in @ring, 0 if @ring is NULL.
+ */
+size_t ring_length(ring_t ring);
+
+#endif /* _RING_H */
@@ -0,0 +1,375 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "heap.h"
+#include "private.h"
+#include "ring.h"
+
+#define ERROR_FOUND     -1
+#define NO_ERROR         0
+
+/*
+ * ready_q : non-user level ring buffer data structure
+ *  
+ * This data struture is responsible for holding
+ * all ready threads with the FIFO policy. Thus 
+ * helps manage all threads that are neither 
+ * Running nor Blocked
+ * 
+ * Implementation of such data structure allows
+ * O(1) time complexity for storing and extracting
+ * information through push and pop. As the TCB
+ * pointers are stored in one array, neither a push
+ * nor a pop allocates memory or chases pointers.
+ */
+static ring_t ready_q;
+
+/*
+ * ready_heap : non-user level heap data structure
+ *  
+ * Holds the ready threads with the EDF and FAIR 
+ * policies, keyed by their absolute deadline or 
+ * their virtual runtime, so that the thread of 
+ * earliest deadline or of least virtual runtime is
+ * always popped first.
+ */
+static heap_t ready_heap;
+
+/* 
+ * FIFO policy
+ *
+ * Ready threads run in turns, from ready_q. The policy never keeps a thread
+ * running once another one is ready, so it has no decision hook at all.
+ */
+static int fifo_init(void)
+{
+    ready_q = ring_create();
+
+    return ready_q == NULL ? ERROR_FOUND : NO_ERROR;
+}
+
+static void fifo_fini(void)
+{
+    ring_destroy(ready_q);
+    ready_q = NULL;
+}
+
+static int fifo_reserve(size_t count)
+{
+    return ring_reserve(ready_q, count);
+}
+
+static void fifo_enqueue(struct uthread_tcb *tcb)
+{
+    uthread_sched_entity(tcb)->ticket = ring_next_ticket(ready_q);
+    ring_push(ready_q, tcb);
+}
+
+static void fifo_enqueue_batch(struct uthread_tcb *const tcbs[], size_t count)
+{
+    size_t ticket = ring_next_ticket(ready_q);
+
+    for(size_t i = 0; i < count; i++)
+        uthread_sched_entity(tcbs[i])->ticket = ticket + i;
+
+    ring_push_batch(ready_q, (void *const *) tcbs, count);
+}
+
+static struct uthread_tcb *fifo_pick_next(void)
+{
+    struct uthread_tcb *tcb = NULL;
+
+    ring_pop(ready_q, (void**) &tcb);
+
+    return tcb;
+}
+
+static size_t fifo_nr_ready(void)
+{
+    return ring_length(ready_q);
+}
+
+static int fifo_yield_to(struct uthread_tcb *curr, struct uthread_tcb *tcb)
+{
+    size_t ticket = uthread_sched_entity(tcb)->ticket;
+    void **slot = ring_slot(ready_q, ticket);
+
+    if(slot == NULL || *slot != tcb)
+        return ERROR_FOUND;
+
+    /* The running thread takes the place of @tcb in the line, 
+       so that neither the ring grows nor the other threads wait
+       any longer */
+    *slot = curr;
+    uthread_sched_entity(curr)->ticket = ticket;
+
+    return NO_ERROR;
+}
+
+const struct uthread_sched_ops uthread_sched_fifo = {
+    .name          = "fifo",
+    .init          = fifo_init,
+    .fini          = fifo_fini,
+    .reserve       = fifo_reserve,
+    .enqueue       = fifo_enqueue,
+    .enqueue_batch = fifo_enqueue_batch,
+    .pick_next     = fifo_pick_next,
+    .nr_ready      = fifo_nr_ready,
+    .yield_to      = fifo_yield_to,
+};
+
+/*
+ * Heap based policies
+ *
+ * EDF and FAIR share ready_heap, and only differ by the key of their threads.
+ */
+static int heap_sched_init(void)
+{
+    ready_heap = heap_create();
+
+    return ready_heap == NULL ? ERROR_FOUND : NO_ERROR;
+}
+
+static void heap_sched_fini(void)
+{
+    heap_destroy(ready_heap);
+    ready_heap = NULL;
+}
+
+static int heap_sched_reserve(size_t count)
+{
+    return heap_reserve(ready_heap, count);
+}
+
+static struct uthread_tcb *heap_sched_pick_next(void)
+{
+    struct uthread_tcb *tcb = NULL;
+
+    heap_pop(ready_heap, (void**) &tcb);
+
+    return tcb;
+}
+
+static size_t heap_sched_nr_ready(void)
+{
+    return heap_length(ready_heap);
+}
+
+/* Key of the first ready thread, UINT64_MAX if none */
+static uint64_t heap_sched_first_key(void)
+{
+    uint64_t key = UINT64_MAX;
+
+    heap_peek_key(ready_heap, &key);
+
+    return key;
+}
+
+/* 
+ * heap_sched_yield_to - Directed yield of the heap based policies
+ *
+ * Unlike with FIFO, the running thread is enqueued by its own key rather than
+ * in place of @tcb, and looking @tcb up is O(n).
+ */
+static int heap_sched_yield_to(struct uthread_tcb *curr,
+                               struct uthread_tcb *tcb,
+                               void (*enqueue)(struct uthread_tcb *))
+{
+    if(heap_remove(ready_heap, tcb))
+        return ERROR_FOUND;
+
+    enqueue(curr);
+
+    return NO_ERROR;
+}
+
+/* 
+ * EDF policy
+ *
+ * The ready thread of earliest deadline runs first. A tick does not switch
+ * away unless a ready thread has a deadline as early as the running one. A
+ * thread made ready with an earlier deadline preempts the running one, as
+ * does a ready thread once the running one pushed its own deadline back.
+ */
+static void edf_enqueue(struct uthread_tcb *tcb)
+{
+    heap_push(ready_heap, uthread_sched_entity(tcb)->deadline, tcb);
+}
+
+static bool edf_on_tick(struct uthread_tcb *curr, bool involuntary)
+{
+    /* A yield always gives way, so that spinning on uthread_yield() 
+       cannot starve the threads of later deadlines */
+    return involuntary &&
+           heap_sched_first_key() > uthread_sched_entity(curr)->deadline;
+}
+
+static bool edf_check_preempt(struct uthread_tcb *curr,
+                              struct uthread_tcb *tcb)
+{
+    return uthread_sched_entity(tcb)->deadline <
+           uthread_sched_entity(curr)->deadline;
+}
+
+static bool edf_check_deadline(struct uthread_tcb *curr)
+{
+    return heap_sched_first_key() < uthread_sched_entity(curr)->deadline;
+}
+
+static int edf_yield_to(struct uthread_tcb *curr, struct uthread_tcb *tcb)
+{
+    return heap_sched_yield_to(curr, tcb, edf_enqueue);
+}
+
+const struct uthread_sched_ops uthread_sched_edf = {
+    .name           = "edf",
+    .init           = heap_sched_init,
+    .fini           = heap_sched_fini,
+    .reserve        = heap_sched_reserve,
+    .enqueue        = edf_enqueue,
+    .pick_next      = heap_sched_pick_next,
+    .nr_ready       = heap_sched_nr_ready,
+    .on_tick        = edf_on_tick,
+    .check_preempt  = edf_check_preempt,
+    .check_deadline = edf_check_deadline,
+    .yield_to       = edf_yield_to,
+};
+
+/*
+ * min_vruntime : non-user level fair scheduling clock
+ *  
+ * Never decreasing lower bound of the virtual runtime
+ * of the runnable threads, with the FAIR policy. New 
+ * threads start from it, and waking threads are 
+ * brought up to SLEEPER_CREDIT below it, so that 
+ * neither can take over the CPU for long.
+ */
+static uint64_t min_vruntime;
+
+/* Weight of a thread of priority 0 */
+#define NICE_0_WEIGHT 1024
+
+/* Largest credit of virtual runtime of a thread waking up (in ns) */
+#define SLEEPER_CREDIT 5000000
+
+/* Virtual runtime lead a thread waking up needs to preempt (in ns) */
+#define WAKEUP_GRANULARITY 1000000
+
+/* 
+ * prio_to_weight - Weight of each priority, from 20 to -19
+ *
+ * Each step of priority is worth about 25% of CPU time, as with the nice 
+ * levels of Linux, which use the same weights.
+ */
+static const unsigned prio_to_weight[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906,
+    3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423,
+    335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45,
+    36, 29, 23, 18, 15,
+};
+
+/* 
+ * FAIR policy
+ *
+ * Each thread accrues virtual runtime, its CPU time scaled by NICE_0_WEIGHT
+ * over its weight, and the ready thread of least virtual runtime runs first.
+ * The running thread keeps the CPU while its virtual runtime is the least.
+ */
+static int fair_init(void)
+{
+    min_vruntime = 0;
+
+    return heap_sched_init();
+}
+
+static void fair_enqueue(struct uthread_tcb *tcb)
+{
+    heap_push(ready_heap, uthread_sched_entity(tcb)->vruntime, tcb);
+}
+
+static struct uthread_tcb *fair_pick_next(void)
+{
+    struct uthread_tcb *tcb = heap_sched_pick_next();
+
+    if(tcb == NULL)
+        return NULL;
+
+    /* Move the clock on to the least virtual runtime still runnable */
+    uint64_t runnable = uthread_sched_entity(tcb)->vruntime;
+
+    if(heap_sched_first_key() < runnable)
+        runnable = heap_sched_first_key();
+    if(runnable > min_vruntime)
+        min_vruntime = runnable;
+
+    return tcb;
+}
+
+static void fair_charge(struct uthread_tcb *curr, uint64_t ran_ns)
+{
+    struct uthread_sched_entity *se = uthread_sched_entity(curr);
+    int priority = se->priority;
+
+    if(priority > 20)
+        priority = 20;
+    if(priority < -19)
+        priority = -19;
+
+    se->vruntime += ran_ns * NICE_0_WEIGHT / prio_to_weight[20 - priority];
+}
+
+static void fair_on_create(struct uthread_tcb *tcb)
+{
+    uthread_sched_entity(tcb)->vruntime = min_vruntime;
+}
+
+static void fair_on_wake(struct uthread_tcb *tcb)
+{
+    struct uthread_sched_entity *se = uthread_sched_entity(tcb);
+
+    /* Credit a sleeping thread with some virtual runtime, but not 
+       so much that it could hog the CPU */
+    if(min_vruntime > SLEEPER_CREDIT &&
+       se->vruntime < min_vruntime - SLEEPER_CREDIT)
+        se->vruntime = min_vruntime - SLEEPER_CREDIT;
+}
+
+static bool fair_on_tick(struct uthread_tcb *curr, bool involuntary)
+{
+    (void) involuntary;
+
+    return heap_sched_first_key() > uthread_sched_entity(curr)->vruntime;
+}
+
+static bool fair_check_preempt(struct uthread_tcb *curr,
+                               struct uthread_tcb *tcb)
+{
+    return uthread_sched_entity(tcb)->vruntime + WAKEUP_GRANULARITY <
+           uthread_sched_entity(curr)->vruntime;
+}
+
+static int fair_yield_to(struct uthread_tcb *curr, struct uthread_tcb *tcb)
+{
+    return heap_sched_yield_to(curr, tcb, fair_enqueue);
+}
+
+const struct uthread_sched_ops uthread_sched_fair = {
+    .name          = "fair",
+    .init          = fair_init,
+    .fini          = heap_sched_fini,
+    .reserve       = heap_sched_reserve,
+    .enqueue       = fair_enqueue,
+    .pick_next     = fair_pick_next,
+    .nr_ready      = heap_sched_nr_ready,
+    .charge        = fair_charge,
+    .on_create     = fair_on_create,
+    .on_wake       = fair_on_wake,
+    .on_tick       = fair_on_tick,
+    .check_preempt = fair_check_preempt,
+    .yield_to      = fair_yield_to,
+};
@@ -1,15 +1,31 @@
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include "uthread.h"
 #include "queue.h"
 #include "sem.h"
 #include "private.h"
+#include "tqueue.h"
 
 #define ERROR   -1
 #define NO_ERROR 0
 
+/* Number of yields of the first waiter of a spinning semaphore */
+#define SEM_SPIN_INITIAL 4
+
+/*
+ * waiter_queue - non-user level wait list
+ * 
+ * Chains the wait records of the blocked threads
+ * (see uthread_waiter()), so that blocking never
+ * allocates memory.
+ */
+QUEUE_DEFINE(waiter_queue, struct uthread_waiter, next)
+
 /*
  * semaphore - user level data type to for Synchronzing Access
  *  
@@ -28,49 +44,231 @@
  * 1. resources_avail           : a.k.a 'count', keep track of # of 
  *                                resources still available to threads
  * 
- * 2. block_threads             : a queue which stores threads that 
- *                                are being blocked.
+ * 2. block_threads             : a queue which stores the waiters
+ *                                of the threads being blocked.
  * 
  * 3. num_of_blocked_threads    : # of blocked threads stored
  *                                in block_threads;
+ * 
+ * 4. name                      : label of the semaphore in the
+ *                                statistics, may be NULL
+ * 
+ * 5. stats                     : contention statistics, NULL if
+ *                                the semaphore is not instrumented
+ * 
+ * 6. registration              : handle of the semaphore in 
+ *                                instrumented_sems, if instrumented
+ * 
+ * 7. owner                     : thread which last took a resource, 
+ *                                NULL once it put it back
+ * 
+ * 8. spin_max, spin_budget     : largest and current number of 
+ *                                yields of a waiter before it blocks
+ * 
+ * 9. num_of_spinning_threads   : # of threads yielding in sem_down()
  */
 
 typedef struct semaphore 
 {
     size_t resources_avail;
-    queue_t blocked_threads;
+    struct waiter_queue blocked_threads;
     int num_of_blocked_threads;
 
+    char *name;
+    struct sem_stats *stats;
+    queue_handle_t registration;
+
+    struct uthread_tcb *owner;
+    unsigned spin_max;
+    unsigned spin_budget;
+    int num_of_spinning_threads;
+
 } semaphore;
 
+
+/*
+ * instrumented_sems - non-user level queue data structure
+ * 
+ * Holds every semaphore created with sem_create_named(),
+ * so that sem_stats_dump() can rank them.
+ */
+queue_t instrumented_sems;
+
+/* 
+ * sem_now_us - Current time in microseconds
+ */
+static uint64_t sem_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * sem_stats_bucket - Histogram bucket of a wait time
+ * @wait_us: Wait time in microseconds
+ */
+static int sem_stats_bucket(uint64_t wait_us)
+{
+    int bucket = 0;
+
+    while(wait_us > 0 && bucket < SEM_STATS_BUCKETS - 1) {
+        wait_us >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
 sem_t sem_create(size_t count)
 {
+    /* Allocate with preemption disabled, as the allocator 
+       cannot be reentered by another thread */
+    preempt_disable();
+
     /* Initialize space for the new semaphore */
     sem_t sem = malloc(sizeof(semaphore));
 
     /* If no space available, return NULL */
-    if(sem == NULL)
+    if(sem == NULL) {
+        preempt_enable();
         return NULL;
+    }
 
     /* Create the semaphore */
-    sem->blocked_threads        = queue_create();
+    waiter_queue_init(&sem->blocked_threads);
     sem->resources_avail        = count;
     sem->num_of_blocked_threads = 0;
+    sem->name                   = NULL;
+    sem->stats                  = NULL;
+    sem->registration           = NULL;
+    sem->owner                  = NULL;
+    sem->spin_max               = 0;
+    sem->spin_budget            = 0;
+    sem->num_of_spinning_threads = 0;
+
+    preempt_enable();
 
     return sem;
 }
 
-int sem_destroy(sem_t sem)
+sem_t sem_create_named(size_t count, const char *name)
 {
+    sem_t sem = sem_create(count);
+
+    if(sem == NULL)
+        return NULL;
+
     preempt_disable();
 
-    /* Check if sem is NULL and if the blocked thread queue is empty */
-    if(sem == NULL || queue_length(sem->blocked_threads) > 0)
+    sem->stats = calloc(1, sizeof(struct sem_stats));
+    if(sem->stats == NULL) {
+        free(sem);
+        preempt_enable();
+        return NULL;
+    }
+
+    if(name != NULL)
+        sem->name = strdup(name);
+
+    /* Register the semaphore so it shows up in the dump */
+
+    if(instrumented_sems == NULL)
+        instrumented_sems = queue_create();
+    sem->registration = queue_enqueue_handle(instrumented_sems, sem);
+
+    preempt_enable();
+
+    return sem;
+}
+
+int sem_set_spin(sem_t sem, unsigned max_yields)
+{
+    if(sem == NULL)
         return ERROR;
 
-    /* Free the queue's space */
-    if(queue_destroy(sem->blocked_threads))
+    preempt_disable();
+
+    sem->spin_max    = max_yields;
+    sem->spin_budget = max_yields < SEM_SPIN_INITIAL ? max_yields 
+                                                     : SEM_SPIN_INITIAL;
+
+    preempt_enable();
+
+    return NO_ERROR;
+}
+
+/*
+ * sem_spin - Wait for a semaphore by yielding
+ * @sem: Semaphore to wait for
+ *
+ * Yield up to spin_budget times, for as long as the owner of @sem can still
+ * run and give it back, and take a resource as soon as one is available. The
+ * budget is tuned to twice the number of yields the last successful wait
+ * took, and halves when the whole budget was used in vain.
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: true if a resource was taken, false if the caller has to block.
+ */
+static bool sem_spin(sem_t sem)
+{
+    struct uthread_tcb *self = uthread_current();
+    unsigned budget = sem->spin_budget;
+    unsigned yields = 0;
+    bool taken = false;
+
+    sem->num_of_spinning_threads++;
+
+    for(;;)
+    {
+        if(sem->resources_avail > 0) {
+            sem->resources_avail -= 1;
+            taken = true;
+            break;
+        }
+
+        /* Only the owner may give the resource back soon */
+        if(yields == budget || sem->owner == NULL || sem->owner == self || 
+           !uthread_runnable(sem->owner))
+            break;
+
+        preempt_enable();
+        uthread_yield();
+        preempt_disable();
+
+        yields++;
+    }
+
+    sem->num_of_spinning_threads--;
+
+    if(taken && yields * 2 > budget)
+        sem->spin_budget = yields * 2 < sem->spin_max ? yields * 2
+                                                      : sem->spin_max;
+    else if(!taken && yields == budget && budget > 1)
+        sem->spin_budget = budget / 2;
+
+    return taken;
+}
+
+int sem_destroy(sem_t sem)
+{
+    preempt_disable();
+
+    /* Check if sem is NULL and if no thread waits for it */
+    if(sem == NULL || !waiter_queue_empty(&sem->blocked_threads) ||
+       sem->num_of_spinning_threads > 0) {
+        preempt_enable();
         return ERROR;
+    }
+
+    /* Unregister instrumented semaphores */
+    if(sem->stats != NULL) {
+        queue_remove_handle(instrumented_sems, sem->registration);
+        free(sem->stats);
+        free(sem->name);
+    }
 
     /* Free the remaining allocated space for the semaphore */
     free(sem);
@@ -82,54 +280,212 @@ int sem_destroy(sem_t sem)
 
 int sem_down(sem_t sem)
 {
-    preempt_disable();
-
     /* Semaphore being passed is NULL, execution failed */
     if(sem == NULL)
         return ERROR;
 
-    /* If no resources are available block the current thread */
-    while(sem->resources_avail == 0)
-    {
-        sem->num_of_blocked_threads++;
-        queue_enqueue(sem->blocked_threads, (void*)uthread_current());
-        uthread_block();
-    }
+    preempt_disable();
 
     /* If resources are available, take one of those resources. */
     if(sem->resources_avail > 0)
     {
         sem->resources_avail -= 1;
+        sem->owner = uthread_current();
+
+        if(sem->stats != NULL)
+            sem->stats->acquires++;
+
+        preempt_enable();
+
+        return NO_ERROR;
     }
 
-    preempt_enable();
+    /* Yielding may be cheaper than blocking, unless others already 
+       block, which are to get the resource first */
+    if(sem->spin_max > 0 && waiter_queue_empty(&sem->blocked_threads) &&
+       sem_spin(sem))
+    {
+        sem->owner = uthread_current();
+
+        if(sem->stats != NULL) {
+            sem->stats->acquires++;
+            sem->stats->spun++;
+        }
+
+        preempt_enable();
+
+        return NO_ERROR;
+    }
+
+    /* Otherwise block the current thread, until sem_up() hands 
+       a resource over to it. The semaphore is not touched past
+       that point, as it may be destroyed as soon as the resource
+       was handed over. */
+    struct uthread_waiter *waiter = uthread_waiter(uthread_current());
+
+    waiter->wait_start = sem->stats != NULL ? sem_now_us() : 0;
+
+    sem->num_of_blocked_threads++;
+    waiter_queue_enqueue(&sem->blocked_threads, waiter);
+
+    if(sem->stats != NULL && 
+       (uint64_t) sem->num_of_blocked_threads > sem->stats->max_queue_depth)
+        sem->stats->max_queue_depth = sem->num_of_blocked_threads;
+
+    uthread_block();
 
     return NO_ERROR;
 }
 
 int sem_up(sem_t sem)
 {
-    preempt_disable();
-
     /* Check to make sure the semaphore being passed is not NULL */
     if(sem == NULL)
         return ERROR;
 
-    struct uthread_tcb *thread_to_unblock;
+    preempt_disable();
+
+    /* If there are no blocked threads, put one of the resources 
+       back and allow other threads to take it */
+    if(sem->num_of_blocked_threads == 0)
+    {
+        sem->resources_avail += 1;
+        if(sem->owner == uthread_current())
+            sem->owner = NULL;
+        preempt_enable();
+        return NO_ERROR;
+    }
 
-    /* Put one of the resources back and allow other threads to take it */
-    sem->resources_avail += 1;
+    /* Otherwise hand the resource directly to the first thread 
+       in the queue, so that no other thread can take it first */
+    sem->num_of_blocked_threads--;
+    struct uthread_waiter *waiter = waiter_queue_dequeue(&sem->blocked_threads);
 
-    /* If there are blocked threads, unblock the first one in the queue
-       Move this queue to the front of the queue in uthread.c */
-    if(sem->num_of_blocked_threads > 0)
+    /* Record the acquisition on behalf of the waiter, and how 
+       long it waited for it */
+    if(sem->stats != NULL)
     {
-        sem->num_of_blocked_threads--;
-        queue_dequeue(sem->blocked_threads, (void **) &thread_to_unblock);
-        uthread_unblock(thread_to_unblock);
+        uint64_t wait_us = sem_now_us() - waiter->wait_start;
+
+        sem->stats->acquires++;
+        sem->stats->contended++;
+        sem->stats->wait_hist[sem_stats_bucket(wait_us)]++;
     }
 
+    sem->owner = waiter->thread;
+    uthread_unblock(waiter->thread);
+
     preempt_enable();
 
     return NO_ERROR;
-}
\ No newline at end of file
+}
+
+int sem_stats(sem_t sem, struct sem_stats *stats)
+{
+    if(sem == NULL || stats == NULL || sem->stats == NULL)
+        return ERROR;
+
+    preempt_disable();
+    *stats = *sem->stats;
+    preempt_enable();
+
+    return NO_ERROR;
+}
+
+/* 
+ * dump_sems - Instrumented semaphores collected by sem_stats_dump()
+ */
+static sem_t *dump_sems;
+static size_t dump_count;
+
+static void sem_stats_collect(void *data)
+{
+    dump_sems[dump_count++] = (sem_t) data;
+}
+
+/* Order semaphores from the most to the least contended */
+static int sem_stats_compare(const void *a, const void *b)
+{
+    const struct sem_stats *stats_a = (*(const sem_t *) a)->stats;
+    const struct sem_stats *stats_b = (*(const sem_t *) b)->stats;
+
+    if(stats_a->contended != stats_b->contended)
+        return stats_a->contended < stats_b->contended ? 1 : -1;
+    if(stats_a->acquires != stats_b->acquires)
+        return stats_a->acquires < stats_b->acquires ? 1 : -1;
+
+    return 0;
+}
+
+int sem_stats_dump(FILE *stream, size_t top_n)
+{
+    if(stream == NULL)
+        return ERROR;
+
+    preempt_disable();
+
+    int num_of_sems = queue_length(instrumented_sems);
+
+    if(num_of_sems <= 0) {
+        preempt_enable();
+        return 0;
+    }
+
+    /* Snapshot the registry, then rank it */
+    dump_sems  = malloc(num_of_sems * sizeof(sem_t));
+    dump_count = 0;
+    if(dump_sems == NULL) {
+        preempt_enable();
+        return ERROR;
+    }
+
+    queue_iterate(instrumented_sems, sem_stats_collect);
+    qsort(dump_sems, dump_count, sizeof(sem_t), sem_stats_compare);
+
+    if(top_n > dump_count)
+        top_n = dump_count;
+
+    fprintf(stream, "%-24s %12s %12s %10s\n",
+            "semaphore", "acquires", "contended", "max depth");
+
+    for(size_t i = 0; i < top_n; i++)
+    {
+        sem_t sem = dump_sems[i];
+        char label[32];
+
+        if(sem->name == NULL)
+            snprintf(label, sizeof(label), "%p", (void*) sem);
+
+        fprintf(stream, "%-24s %12llu %12llu %10llu\n",
+                sem->name != NULL ? sem->name : label,
+                (unsigned long long) sem->stats->acquires,
+                (unsigned long long) sem->stats->contended,
+                (unsigned long long) sem->stats->max_queue_depth);
+
+        /* Only print the buckets that recorded a wait */
+        for(int bucket = 0; bucket < SEM_STATS_BUCKETS; bucket++)
+        {
+            uint64_t count = sem->stats->wait_hist[bucket];
+
+            if(count == 0)
+                continue;
+
+            if(bucket == 0)
+                fprintf(stream, "    wait < 1 us: %llu\n",
+                        (unsigned long long) count);
+            else if(bucket == SEM_STATS_BUCKETS - 1)
+                fprintf(stream, "    wait >= %llu us: %llu\n",
+                        1ULL << (bucket - 1), (unsigned long long) count);
+            else
+                fprintf(stream, "    wait < %llu us: %llu\n",
+                        1ULL << bucket, (unsigned long long) count);
+        }
+    }
+
+    free(dump_sems);
+    dump_sems = NULL;
+
+    preempt_enable();
+
+    return top_n;
+}
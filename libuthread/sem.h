@@ -2,6 +2,7 @@
 #define _SEMAPHORE_H
 
 #include <stdint.h>
+#include <stdio.h>
 #include <sys/types.h>
 
 /*
@@ -26,14 +27,48 @@ typedef struct semaphore *sem_t;
  */
 sem_t sem_create(size_t count);
 
+/*
+ * sem_create_named - Create instrumented semaphore
+ * @count: Semaphore count
+ * @name: Label of the semaphore in the statistics, or NULL
+ *
+ * Same as sem_create(), except that the semaphore records contention
+ * statistics, which can be retrieved with sem_stats() and are listed by
+ * sem_stats_dump(). The string @name is copied.
+ *
+ * Return: Pointer to initialized semaphore. NULL in case of failure when
+ * allocating the new semaphore.
+ */
+sem_t sem_create_named(size_t count, const char *name);
+
+/*
+ * sem_set_spin - Let waiters yield before blocking on a semaphore
+ * @sem: Semaphore to configure
+ * @max_yields: Largest number of times a waiter yields, 0 to always block
+ *
+ * By default, sem_down() blocks the caller as soon as @sem is unavailable. With
+ * @max_yields > 0, it first yields to the other threads for a while, as long
+ * as the thread which last took @sem is still able to run and give it back,
+ * and only blocks if @sem did not become available meanwhile. Blocking and
+ * being unblocked again costs more than a few yields when @sem is held for
+ * short periods. The number of yields adapts to how long waiters recently
+ * waited, up to @max_yields, and halves whenever yielding did not pay off.
+ *
+ * A yielding waiter is not queued, so unlike a blocked one it may be overtaken
+ * by another thread taking @sem in the meantime.
+ *
+ * Return: -1 if @sem is NULL. 0 otherwise.
+ */
+int sem_set_spin(sem_t sem, unsigned max_yields);
+
 /*
  * sem_destroy - Deallocate a semaphore
  * @sem: Semaphore to deallocate
  *
  * Deallocate semaphore @sem.
  *
- * Return: -1 if @sem is NULL or if other threads are still being blocked on
- * @sem. 0 is @sem was successfully destroyed.
+ * Return: -1 if @sem is NULL or if other threads are still being blocked on,
+ * or yielding in sem_down() for, @sem. 0 is @sem was successfully destroyed.
  */
 int sem_destroy(sem_t sem);
 
@@ -56,12 +91,57 @@ int sem_down(sem_t sem);
  *
  * Release a resource to semaphore @sem.
  *
- * If the waiting list associated to @sem is not empty, releasing a resource
- * also causes the first thread (i.e. the oldest) in the waiting list to be
- * unblocked.
+ * If the waiting list associated to @sem is not empty, the resource is handed
+ * directly to the first thread (i.e. the oldest) in the waiting list, which is
+ * unblocked. Once sem_up() returned, that thread no longer uses @sem, which
+ * may then be destroyed.
  *
  * Return: -1 if @sem is NULL. 0 if semaphore was successfully released.
  */
 int sem_up(sem_t sem);
 
+/* Number of buckets of the wait-time histogram */
+#define SEM_STATS_BUCKETS 24
+
+/*
+ * sem_stats - Semaphore contention statistics
+ * @acquires: Number of successful sem_down()
+ * @contended: Number of sem_down() which had to block at least once
+ * @spun: Number of sem_down() which got the semaphore by yielding, without
+ *	blocking (see sem_set_spin())
+ * @max_queue_depth: Largest number of threads blocked at the same time
+ * @wait_hist: Histogram of the time spent blocked by contended sem_down(),
+ *	bucket 0 counts waits under 1 us and bucket i > 0 counts waits in
+ *	[2^(i-1), 2^i) us. The last bucket also counts all longer waits.
+ */
+struct sem_stats {
+	uint64_t acquires;
+	uint64_t contended;
+	uint64_t spun;
+	uint64_t max_queue_depth;
+	uint64_t wait_hist[SEM_STATS_BUCKETS];
+};
+
+/*
+ * sem_stats - Get contention statistics of a semaphore
+ * @sem: Semaphore created with sem_create_named()
+ * @stats: Address where to copy the statistics
+ *
+ * Return: -1 if @sem or @stats are NULL, or if @sem is not instrumented. 0
+ * otherwise.
+ */
+int sem_stats(sem_t sem, struct sem_stats *stats);
+
+/*
+ * sem_stats_dump - Print the most contended semaphores
+ * @stream: Stream to print to
+ * @top_n: Maximum number of semaphores to print
+ *
+ * List the @top_n instrumented semaphores with the highest contended count,
+ * in decreasing order, along with their wait-time histogram.
+ *
+ * Return: -1 if @stream is NULL, number of semaphores printed otherwise.
+ */
+int sem_stats_dump(FILE *stream, size_t top_n);
+
 #endif /* _SEMAPHORE_H */
@@ -0,0 +1,154 @@
+#ifndef _TQUEUE_H
+#define _TQUEUE_H
+
+#include <stddef.h>
+
+/*
+ * QUEUE_DEFINE - Define a typed queue
+ * @name: Name of the queue type, prefixing the name of its operations
+ * @type: Type of the items, a structure type
+ * @link: Field of @type pointing to the next item, of type @type *
+ *
+ * Unlike queue_t, a typed queue is intrusive: it chains its items through
+ * their own @link field instead of allocating a node for each of them. An item
+ * may therefore only be in one queue per link field at a time, and none of the
+ * operations can fail. All the operations are static inline functions, which
+ * the compiler can inline and specialize for @type:
+ *
+ * struct @name: The queue itself, to be initialized with @name_init() or
+ *	QUEUE_INIT. Its fields are private.
+ * void @name_init(struct @name *queue): Make @queue empty.
+ * int @name_empty(const struct @name *queue): Whether @queue is empty.
+ * size_t @name_length(const struct @name *queue): Number of items in @queue.
+ * @type *@name_peek(const struct @name *queue): Oldest item of @queue, left in
+ *	it, or NULL if @queue is empty.
+ * void @name_enqueue(struct @name *queue, @type *item): Enqueue @item at the
+ *	back of @queue.
+ * @type *@name_dequeue(struct @name *queue): Remove and return the oldest item
+ *	of @queue, or NULL if @queue is empty.
+ * int @name_remove(struct @name *queue, @type *item): Remove @item from
+ *	@queue, in O(n). Return 0 if @item was found, -1 otherwise.
+ * void @name_splice(struct @name *dst, struct @name *src): Move all the items
+ *	of @src to the back of @dst, leaving @src empty.
+ * @type *@name_drain(struct @name *queue): Remove all the items of @queue,
+ *	leaving it empty. Return the oldest one, the others following it in
+ *	order through their @link field, or NULL if @queue was empty.
+ *
+ * Apart from remove, all operations are O(1).
+ */
+#define QUEUE_DEFINE(name, type, link)					\
+struct name {								\
+	type *head;							\
+	type *tail;							\
+	size_t length;							\
+};									\
+									\
+static inline void name##_init(struct name *queue)			\
+{									\
+	queue->head   = NULL;						\
+	queue->tail   = NULL;						\
+	queue->length = 0;						\
+}									\
+									\
+static inline int name##_empty(const struct name *queue)		\
+{									\
+	return queue->head == NULL;					\
+}									\
+									\
+static inline size_t name##_length(const struct name *queue)		\
+{									\
+	return queue->length;						\
+}									\
+									\
+static inline type *name##_peek(const struct name *queue)		\
+{									\
+	return queue->head;						\
+}									\
+									\
+static inline void name##_enqueue(struct name *queue, type *item)	\
+{									\
+	item->link = NULL;						\
+	if (queue->tail != NULL)					\
+		queue->tail->link = item;				\
+	else								\
+		queue->head = item;					\
+	queue->tail = item;						\
+	queue->length++;						\
+}									\
+									\
+static inline type *name##_dequeue(struct name *queue)			\
+{									\
+	type *item = queue->head;					\
+									\
+	if (item == NULL)						\
+		return NULL;						\
+	queue->head = item->link;					\
+	if (queue->head == NULL)					\
+		queue->tail = NULL;					\
+	queue->length--;						\
+	return item;							\
+}									\
+									\
+static inline int name##_remove(struct name *queue, type *item)	\
+{									\
+	type *prev = NULL;						\
+	type *cur;							\
+									\
+	for (cur = queue->head; cur != NULL; prev = cur, cur = cur->link) \
+		if (cur == item)					\
+			break;						\
+	if (cur == NULL)						\
+		return -1;						\
+	if (prev != NULL)						\
+		prev->link = cur->link;					\
+	else								\
+		queue->head = cur->link;				\
+	if (queue->tail == cur)						\
+		queue->tail = prev;					\
+	queue->length--;						\
+	return 0;							\
+}									\
+									\
+static inline void name##_splice(struct name *dst, struct name *src)	\
+{									\
+	if (src->head == NULL)						\
+		return;							\
+	if (dst->tail != NULL)						\
+		dst->tail->link = src->head;				\
+	else								\
+		dst->head = src->head;					\
+	dst->tail = src->tail;						\
+	dst->length += src->length;					\
+	src->head   = NULL;						\
+	src->tail   = NULL;						\
+	src->length = 0;						\
+}									\
+									\
+static inline type *name##_drain(struct name *queue)			\
+{									\
+	type *head = queue->head;					\
+									\
+	queue->head   = NULL;						\
+	queue->tail   = NULL;						\
+	queue->length = 0;						\
+	return head;							\
+}
+
+/*
+ * QUEUE_INIT - Static initializer of an empty typed queue
+ */
+#define QUEUE_INIT { NULL, NULL, 0 }
+
+/*
+ * QUEUE_FOREACH - Iterate over the items of a typed queue
+ * @item: Variable of type @type * set to each item, from the oldest one
+ * @queue: Address of the queue to iterate over
+ * @link: Link field given to QUEUE_DEFINE()
+ *
+ * The loop body is inlined, unlike the callback of queue_iterate(). It must
+ * not remove @item from @queue.
+ */
+#define QUEUE_FOREACH(item, queue, link)				\
+	for ((item) = (queue)->head; (item) != NULL; (item) = (item)->link)
+
+#endif /* _TQUEUE_H */
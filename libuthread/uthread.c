@@ -1,14 +1,19 @@
+#define _GNU_SOURCE
+
 #include <assert.h>
+#include <sched.h>
 #include <signal.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
+#include <time.h>
 
-#include "queue.h"
 #include "private.h"
+#include "tqueue.h"
 #include "uthread.h"
 
 #define NO_ERROR     0
@@ -17,30 +22,34 @@
 typedef struct uthread_tcb * uthread_tcb_t;
 
 /*
- * ready_q : non-user level queue data structure
+ * sched : non-user level scheduling policy
  *  
- * This data struture is responsible for holding
- * all ready threads. Thus helps manage all 
- * threads that are neither Running nor Blocked
- * 
- * Implementation of such data structure allows
- * O(1) time complexity for storing and extracting
- * information through enqueue and dequeue.
+ * Holds the ready threads, and decides which one 
+ * runs next and whether the running thread has to
+ * give way to them. Picked by uthread_start_opts().
  */
-queue_t ready_q;
+const struct uthread_sched_ops *sched = &uthread_sched_fifo;
 
 /*
- * blocked_q : non-user level queue data structure
+ * uthread_task : non-user level run-to-completion task
  *  
- * This data struture is responsible for holding
- * all blocked threads. Thus helps manage all 
- * threads that are neither Ready nor Running
- * 
- * Implementation of such data structure allows
- * O(1) time complexity for storing and extracting
- * information through enqueue and dequeue.
+ * A task only consists of a function and its argument,
+ * run by the main execution thread on its own stack.
+ * Pending tasks are chained through @next, from
+ * task_head to task_tail. Tasks already run are kept
+ * in free_tasks for reuse, so spawning a task usually
+ * does not allocate any memory.
  */
-queue_t blocked_q;
+struct uthread_task
+{
+    uthread_func_t func;
+    void *arg;
+    struct uthread_task *next;
+};
+
+struct uthread_task *task_head;
+struct uthread_task *task_tail;
+struct uthread_task *free_tasks;
 
 /*
  * main_tcb : non-user level Thread Control Block
@@ -56,6 +65,8 @@ queue_t blocked_q;
  * 3. Responsible for Multithreading Scheduling
  *    through an infinite loop, that is breakable 
  *    when there is no any Ready threads.
+ * 4. Running one pending task each time it is
+ *    scheduled, in between the Ready threads.
  * 
  * When this thread is assigned to be the Running
  * thread (a.k.a current_tcb), it will called 
@@ -79,24 +90,166 @@ uthread_tcb_t main_tcb;
  */
 uthread_tcb_t current_tcb;
 
+/* Size of a cache line (in bytes) */
+#define CACHE_LINE 64
+
 /*
  * uthread_tcb : non-user level Thread Control Block
  *  
  * This data struct is responsible for storing all 
- * information of a thread, which are :
- * 1. Thread's ID
- * 2. Thread's State (Ready, Running, Blocked, Exit)
- * 3. A Pointer to top of the assigned Stack
- * 4. Thread Context
+ * information of a thread. It is laid out by how 
+ * often each field is used, so that scheduling only
+ * touches the first cache lines of a TCB :
+ * 
+ * Hot header, first cache line, read by every 
+ * scheduling decision and queue walk :
+ * 1. Thread's Scheduling Entity, its Deadline, 
+ *    Virtual Runtime and Priority, which must come 
+ *    first (see uthread_sched_entity())
+ * 2. Thread's Slot in the arena, and the Generation
+ *    of the slot, which together make its handle
+ * 3. Thread's State (Ready, Running, Blocked, Exit)
+ * 4. A Pointer to the Thread Context, the saved 
+ *    register area being kept out of the TCB
+ * 5. Link to the next TCB of the queue the thread
+ *    is in, blocked, zombie or free
+ * 
+ * Second cache line, updated on every switch :
+ * 6. The time at which the thread entered its 
+ *    current state
+ * 7. Runtime Statistics
+ * 8. Wait Record, which links the thread into the
+ *    wait list of a semaphore or executor while it
+ *    is blocked (see uthread_waiter())
+ * 
+ * Cold part, only used at creation and exit or on 
+ * request of the thread itself :
+ * 9. Uthread-local storage slots, one per key
+ * 10. Thread's Name, as given by its creation 
+ *     attributes
+ * 11. A Pointer to top of the assigned Stack, and
+ *     its Size and Mode, to deallocate it
+ * 12. The Slab the Stack was carved out of, if it
+ *     was created by uthread_create_batch()
  */
 typedef struct uthread_tcb
 {
-    int tid;                
+    struct uthread_sched_entity se;
+    uint32_t slot;
+    uint32_t generation;
     unsigned state;       
+    uthread_ctx_t *ctx;    
+    struct uthread_tcb *next;
+
+    uint64_t state_since __attribute__((aligned(CACHE_LINE)));
+    struct uthread_stats stats;
+    struct uthread_waiter waiter;
+
+    void *specific[UTHREAD_KEYS_MAX] __attribute__((aligned(CACHE_LINE)));
+
+    char name[UTHREAD_NAME_MAX];
+
     void *stack;           
-    uthread_ctx_t ctx;    
+    size_t stack_size;
+    enum uthread_stack_mode stack_mode;
+    struct stack_slab *slab;
+
+} __attribute__((aligned(CACHE_LINE))) uthread_tcb;
 
-} uthread_tcb;
+_Static_assert(offsetof(uthread_tcb, se) == 0,
+	       "the scheduling entity must be the first member of the TCB");
+_Static_assert(offsetof(uthread_tcb, state_since) == CACHE_LINE,
+	       "the hot header of the TCB must fit in one cache line");
+
+/*
+ * tcb_queue : non-user level typed queue of TCBs
+ *  
+ * Chains TCBs through their @next link, so that a 
+ * thread can be queued without allocating memory, 
+ * and all of the queue operations are inlined.
+ */
+QUEUE_DEFINE(tcb_queue, uthread_tcb, next)
+
+/*
+ * zombie_q : non-user level queue data structure
+ *  
+ * This data struture is responsible for holding
+ * all exited threads whose stack and TCB were not
+ * freed yet. An exiting thread is still running on
+ * its own stack, so it cannot free it itself: it is
+ * reaped later on by uthread_reap().
+ */
+struct tcb_queue zombie_q;
+
+/*
+ * stack_slab : non-user level block of stacks
+ *  
+ * The stacks of the threads created by one call to
+ * uthread_create_batch() are carved out of a single
+ * allocation, right after this header. Once the last
+ * of these threads is reaped, the largest slab is kept
+ * in spare_slab for the next batch, so that its pages
+ * are not faulted in again, and the others are freed.
+ */
+struct stack_slab
+{
+    size_t num_stacks;
+    size_t users;
+
+} __attribute__((aligned(CACHE_LINE)));
+
+struct stack_slab *spare_slab;
+
+/* Number of TCBs carved out of each arena chunk */
+#define TCB_CHUNK_SIZE 64
+
+/*
+ * tcb_chunk : non-user level block of TCBs
+ *  
+ * TCBs are allocated from cache-aligned chunks, so 
+ * that TCBs never share a cache line and their hot 
+ * headers are packed together, rather than being 
+ * spread all over the heap. The contexts of the 
+ * TCBs of a chunk are kept in a separate array, out
+ * of the way of queue walks.
+ * 
+ * The arena numbers its TCBs by slot, slot i being
+ * TCB i % TCB_CHUNK_SIZE of chunk i / TCB_CHUNK_SIZE
+ * in tcb_chunks, so that a handle is turned back into
+ * its TCB by indexing. The arena grows one chunk at a
+ * time, and the chunks are only released by 
+ * uthread_start().
+ * 
+ * TCBs of exited threads are put back on free_tcbs,
+ * chained through their @next link. The generation of
+ * a slot is bumped each time it is handed out, so that
+ * handles of the threads which used the slot before
+ * are recognized as stale.
+ */
+struct tcb_chunk
+{
+    uthread_tcb tcbs[TCB_CHUNK_SIZE];
+    uthread_ctx_t ctxs[TCB_CHUNK_SIZE];
+};
+
+struct tcb_chunk **tcb_chunks;
+size_t num_tcb_chunks;
+size_t max_tcb_chunks;
+uthread_tcb_t free_tcbs;
+
+/* key_destructors -- Destructor of each created key
+ * num_of_keys     -- Number of keys created so far
+ */
+void (*key_destructors[UTHREAD_KEYS_MAX])(void *);
+unsigned num_of_keys;
+
+/* total_stats -- Statistics of the whole runtime
+ *
+ * Every counter charged to a thread is also charged
+ * here, so that it keeps the contribution of threads
+ * that have already exited.
+ */
+struct uthread_stats total_stats;
 
 /* num_of_threads -- The total number of threads 
  *                   currently in either Ready, 
@@ -116,7 +269,8 @@ int num_of_threads;
  * 
  * Ready   -- Available to be selected and executing
  *            tasks. The Ready threads are stored
- *            in ready_q.
+ *            in the ready queue
+ *            of the scheduling policy.
  *              
  * Blocked -- Not Available to be selected and execute
  *            any tasks unless being unblock(). 
@@ -131,142 +285,906 @@ enum Thread_State {
     EXIT
 };
 
-void uthread_yield(void)
+/*
+ * uthread_now - Current time in nanoseconds
+ */
+static uint64_t uthread_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * uthread_tcb_alloc - Allocate a zeroed TCB and its context from the arena
+ *
+ * Must be called with preemption disabled.
+ *
+ * Return: New TCB, or NULL in case of memory allocation error
+ */
+static uthread_tcb_t uthread_tcb_alloc(void)
+{
+	uthread_tcb_t tcb;
+	uthread_ctx_t *ctx;
+
+	uint32_t slot, generation;
+
+	if(free_tcbs == NULL) {
+		struct tcb_chunk *chunk;
+
+		/* Make room for one more chunk in the table */
+		if(num_tcb_chunks == max_tcb_chunks) {
+			size_t max = max_tcb_chunks ? 2 * max_tcb_chunks : 8;
+			struct tcb_chunk **chunks = realloc(tcb_chunks,
+							    max * sizeof(*chunks));
+
+			if(chunks == NULL)
+				return NULL;
+			tcb_chunks     = chunks;
+			max_tcb_chunks = max;
+		}
+
+		chunk = aligned_alloc(CACHE_LINE, sizeof(struct tcb_chunk));
+		if(chunk == NULL)
+			return NULL;
+
+		/* Chain the TCBs in order, so that they are handed out in
+		   address order */
+		for(int i = TCB_CHUNK_SIZE - 1; i >= 0; i--) {
+			chunk->tcbs[i].slot       = num_tcb_chunks *
+						    TCB_CHUNK_SIZE + i;
+			chunk->tcbs[i].generation = 0;
+			chunk->tcbs[i].state      = EXIT;
+			chunk->tcbs[i].ctx        = &chunk->ctxs[i];
+			chunk->tcbs[i].next       = free_tcbs;
+			free_tcbs = &chunk->tcbs[i];
+		}
+
+		tcb_chunks[num_tcb_chunks++] = chunk;
+	}
+
+	tcb       = free_tcbs;
+	free_tcbs = tcb->next;
+
+	ctx        = tcb->ctx;
+	slot       = tcb->slot;
+	generation = tcb->generation + 1;
+	memset(tcb, 0, sizeof(uthread_tcb));
+	memset(ctx, 0, sizeof(uthread_ctx_t));
+	tcb->ctx        = ctx;
+	tcb->slot       = slot;
+	tcb->generation = generation;
+	tcb->se.deadline = UTHREAD_NO_DEADLINE;
+	tcb->waiter.thread = tcb;
+
+	if(sched->on_create != NULL)
+		sched->on_create(tcb);
+
+	return tcb;
+}
+
+/*
+ * uthread_handle - Handle of a thread
+ */
+static uthread_t uthread_handle(uthread_tcb_t tcb)
+{
+	return (uthread_t) tcb->generation << 32 | tcb->slot;
+}
+
+/*
+ * uthread_lookup - Thread designated by a handle
+ *
+ * Return: TCB of the thread, or NULL if @handle is stale or invalid
+ */
+static uthread_tcb_t uthread_lookup(uthread_t handle)
+{
+	uint32_t slot = (uint32_t) handle;
+	uthread_tcb_t tcb;
+
+	/* Generations handed out start at 1, 0 is that of unused slots */
+	if(handle >> 32 == 0 || slot >= num_tcb_chunks * TCB_CHUNK_SIZE)
+		return NULL;
+
+	tcb = &tcb_chunks[slot / TCB_CHUNK_SIZE]->tcbs[slot % TCB_CHUNK_SIZE];
+	if(tcb->generation != handle >> 32 || tcb->state == EXIT)
+		return NULL;
+
+	return tcb;
+}
+
+/*
+ * uthread_tcb_free - Put a TCB back in the arena
+ *
+ * Must be called with preemption disabled.
+ */
+static void uthread_tcb_free(uthread_tcb_t tcb)
+{
+	tcb->state = EXIT;
+	tcb->next  = free_tcbs;
+	free_tcbs = tcb;
+}
+
+/*
+ * uthread_tcb_release_all - Release the whole arena
+ */
+static void uthread_tcb_release_all(void)
+{
+	for(size_t i = 0; i < num_tcb_chunks; i++)
+		free(tcb_chunks[i]);
+	free(tcb_chunks);
+
+	tcb_chunks     = NULL;
+	num_tcb_chunks = 0;
+	max_tcb_chunks = 0;
+	free_tcbs      = NULL;
+}
+
+/*
+ * uthread_set_state - Move a thread to a new state
+ * @tcb: Thread changing state
+ * @state: New state of the thread
+ * @now: Time of the transition
+ *
+ * The time spent in the state being left is charged to the matching counter
+ * of both @tcb and the whole runtime.
+ */
+static void uthread_set_state(uthread_tcb_t tcb, unsigned state, uint64_t now)
+{
+	uint64_t elapsed = now - tcb->state_since;
+
+	switch (tcb->state) {
+	case RUNNING:
+		tcb->stats.cpu_time_ns += elapsed;
+		total_stats.cpu_time_ns += elapsed;
+		break;
+	case READY:
+		tcb->stats.ready_time_ns += elapsed;
+		total_stats.ready_time_ns += elapsed;
+		break;
+	case BLOCKED:
+		tcb->stats.blocked_time_ns += elapsed;
+		total_stats.blocked_time_ns += elapsed;
+		break;
+	}
+
+	tcb->state       = state;
+	tcb->state_since = now;
+}
+
+/*
+ * uthread_charge - Charge the running thread for the CPU time it used
+ * @now: Current time
+ *
+ * Only needed by policies which account CPU time, before they make a decision
+ * involving the running thread.
+ */
+static void uthread_charge(uint64_t now)
+{
+	sched->charge(current_tcb, now - current_tcb->state_since);
+
+	/* Restart the running time of the thread from now */
+	uthread_set_state(current_tcb, RUNNING, now);
+}
+
+/*
+ * uthread_keeps_running - Whether the running thread keeps the CPU
+ * @involuntary: Whether the running thread is being preempted
+ *
+ * Must be called with preemption disabled and at least one thread ready. The
+ * main thread, which only runs the idle loop, always gives way.
+ */
+static bool uthread_keeps_running(bool involuntary)
+{
+	if(current_tcb == main_tcb || sched->on_tick == NULL)
+		return false;
+
+	if(sched->charge != NULL)
+		uthread_charge(uthread_now());
+
+	return sched->on_tick(current_tcb, involuntary);
+}
+
+/*
+ * uthread_switch - Hand the CPU from the running thread to @next
+ * @state: State the running thread is moved to
+ * @next: Thread to run, already removed from the ready queue
+ * @involuntary: Whether the switch is forced by preemption
+ */
+static void uthread_switch(unsigned state, uthread_tcb_t next, bool involuntary)
+{
+	uthread_tcb_t prev = current_tcb;
+	uint64_t now = uthread_now();
+
+	/* Charge prev with the rest of its running time */
+	if (sched->charge != NULL && prev->state == RUNNING)
+		sched->charge(prev, now - prev->state_since);
+
+	if (state != EXIT) {
+		if (involuntary) {
+			prev->stats.involuntary_switches++;
+			total_stats.involuntary_switches++;
+		} else {
+			prev->stats.voluntary_switches++;
+			total_stats.voluntary_switches++;
+		}
+	}
+
+	uthread_set_state(prev, state, now);
+	uthread_set_state(next, RUNNING, now);
+	current_tcb = next;
+
+	uthread_ctx_switch(prev->ctx, next->ctx);
+}
+
+/*
+ * uthread_yield_current - Yield the running thread to the next ready thread
+ * @involuntary: Whether the yield is forced by preemption
+ */
+static void uthread_yield_current(bool involuntary)
 {
 	preempt_disable();
 
-	/* No threads waiting so return and finish execution instead. */
-	if(queue_length(ready_q) == 0)
+	/* No threads waiting so return and finish execution instead.
+	   Depending on the policy, the running thread may also be 
+	   more entitled to the CPU than the first ready thread. */
+	if(sched->nr_ready() == 0 || uthread_keeps_running(involuntary)) {
+		preempt_enable();
 		return;
+	}
 	
-	/* 1. When the running thread yields, it shd be enqueue */
-	current_tcb->state = READY;
-	queue_enqueue(ready_q, current_tcb);
-	uthread_tcb_t prev_tcb = current_tcb;
-
-	// 2. Then, the first thread in the queue shd be dequeue
-	uthread_tcb_t next_tcb = malloc(sizeof(uthread_tcb));
+	/* 1. The first thread in the queue shd be dequeue */
+	uthread_tcb_t next_tcb = sched->pick_next();
 
-	queue_dequeue(ready_q, (void**) &next_tcb);	
+	/* 2. Then, the running thread shd be enqueue, in the slot
+	      just freed, so that this never needs to grow the ring */
+	sched->enqueue(current_tcb);
 
 	/* 3. Now, the dequeued thread (next_tcb) is the running thread
-	      We shd set it to be current_tcb (current running tcb) */
-	next_tcb->state    = RUNNING;
-	current_tcb        = next_tcb;
+	      and run the task assigned for it */
+	uthread_switch(READY, next_tcb, involuntary);
+
+	preempt_enable();
+}
+
+void uthread_yield(void)
+{
+	uthread_yield_current(false);
+}
+
+int uthread_yield_to(uthread_t thread)
+{
+	preempt_disable();
+
+	uthread_tcb_t next_tcb = uthread_lookup(thread);
 
-	/* 4. Now, run the task assigned for next_tcb */
-	uthread_ctx_switch(&prev_tcb->ctx, &current_tcb->ctx);
+	if(next_tcb == NULL || next_tcb->state != READY ||
+	   sched->yield_to == NULL) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	/* The running thread may be enqueued by its CPU time */
+	if(sched->charge != NULL)
+		uthread_charge(uthread_now());
+
+	if(sched->yield_to(current_tcb, next_tcb)) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	uthread_switch(READY, next_tcb, false);
 
 	preempt_enable();
+
+	return NO_ERROR;
 }
 
-void uthread_exit(void)
+/*
+ * uthread_preempt_check - Preempt the running thread for a thread made ready
+ * @tcb: Thread just made ready
+ *
+ * Let the policy decide whether @tcb must run right away, e.g. because its
+ * deadline is earlier than the one of the running thread.
+ */
+static void uthread_preempt_check(uthread_tcb_t tcb)
 {
+	bool preempt;
+
+	if(sched->check_preempt == NULL || current_tcb == NULL)
+		return;
+
 	preempt_disable();
 
-	uthread_tcb_t next_tcb = malloc(sizeof(uthread_tcb));
+	if(sched->charge != NULL)
+		uthread_charge(uthread_now());
 
-	/* Another thread exists that is ready */
-	if(queue_length(ready_q) > 0)
+	/* @tcb may already have run since it was made ready */
+	preempt = tcb->state == READY && sched->check_preempt(current_tcb, tcb);
+
+	preempt_enable();
+
+	if(preempt)
+		uthread_yield_current(true);
+}
+
+void uthread_preempt(void)
+{
+	current_tcb->stats.preemptions++;
+	total_stats.preemptions++;
+
+	uthread_yield_current(true);
+}
+
+void uthread_exit(void)
+{
+	/* Run the destructors of the thread's local storage first, 
+	   since they may use the library */
+	for(unsigned key = 0; key < num_of_keys; key++)
 	{
-		queue_dequeue(ready_q, (void**) &next_tcb);
+		void *value = current_tcb->specific[key];
+
+		if(value == NULL || key_destructors[key] == NULL)
+			continue;
+
+		current_tcb->specific[key] = NULL;
+		key_destructors[key](value);
 	}
 
+	preempt_disable();
+
+	/* Another thread exists that is ready */
+	uthread_tcb_t next_tcb = sched->pick_next();
+
 	/* No other threads exist in the ready queue, 
 	return to uthread_start() and execute main thread */
-	else
-	{
+	if(next_tcb == NULL)
 		next_tcb = main_tcb;
+
+	/* Destroy Current Running Thread, once it is no longer running */
+	tcb_queue_enqueue(&zombie_q, current_tcb);
+	num_of_threads--;
+
+	/* Current Running Thread will be the next thread in the ready queue */
+	uthread_switch(EXIT, next_tcb, false);
+
+	preempt_enable();
+}
+
+/*
+ * uthread_slab_release - Release a slab of stacks no longer used
+ *
+ * Must be called with preemption disabled.
+ */
+static void uthread_slab_release(struct stack_slab *slab)
+{
+	if(spare_slab != NULL && spare_slab->num_stacks >= slab->num_stacks) {
+		free(slab);
+		return;
+	}
+
+	free(spare_slab);
+	spare_slab = slab;
+}
+
+/*
+ * uthread_reap - Free the stack and TCB of all exited threads
+ *
+ * Must be called with preemption disabled.
+ */
+static void uthread_reap(void)
+{
+	uthread_tcb_t zombie, next;
+
+	/* Take the whole queue at once, as freeing a TCB reuses its link */
+	for(zombie = tcb_queue_drain(&zombie_q); zombie != NULL; zombie = next)
+	{
+		next = zombie->next;
+
+		uthread_ctx_release(zombie->ctx);
+
+		if(zombie->slab == NULL)
+			uthread_ctx_destroy_stack(zombie->stack,
+						  zombie->stack_size,
+						  zombie->stack_mode);
+		else if(--zombie->slab->users == 0)
+			uthread_slab_release(zombie->slab);
+
+		uthread_tcb_free(zombie);
 	}
+}
 
-	uthread_tcb_t temp = current_tcb;
+/*
+ * uthread_run_task - Run the oldest pending task, if any
+ *
+ * Return: true if a task was run
+ */
+static bool uthread_run_task(void)
+{
+	preempt_disable();
 
-	/* Destroy Current Running Thread */
-	current_tcb->state = EXIT;
-	uthread_ctx_destroy_stack(current_tcb->stack);
+	struct uthread_task *task = task_head;
 
-	/* Current Running Thread will be the next thread in the ready queue */
-	current_tcb = next_tcb;
-	num_of_threads--;
+	if(task == NULL) {
+		preempt_enable();
+		return false;
+	}
+
+	task_head = task->next;
+	if(task_head == NULL)
+		task_tail = NULL;
+
+	preempt_enable();
 
-	uthread_ctx_switch(&temp->ctx, &next_tcb->ctx);
+	task->func(task->arg);
 
+	/* Keep the task around for the next spawn */
+	preempt_disable();
+	task->next = free_tasks;
+	free_tasks = task;
 	preempt_enable();
+
+	return true;
 }
 
-int uthread_create(uthread_func_t func, void *arg)
+int uthread_spawn_task(uthread_func_t func, void *arg)
+{
+	if(func == NULL)
+		return ERROR_FOUND;
+
+	preempt_disable();
+
+	struct uthread_task *task = free_tasks;
+
+	if(task != NULL) {
+		free_tasks = task->next;
+	} else if((task = malloc(sizeof(struct uthread_task))) == NULL) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	task->func = func;
+	task->arg  = arg;
+	task->next = NULL;
+
+	if(task_tail != NULL)
+		task_tail->next = task;
+	else
+		task_head = task;
+	task_tail = task;
+
+	preempt_enable();
+
+	return NO_ERROR;
+}
+
+void uthread_attr_init(uthread_attr_t *attr)
+{
+	attr->stack_size = UTHREAD_STACK_SIZE;
+	attr->stack_mode = UTHREAD_STACK_FIXED;
+	attr->name       = NULL;
+	attr->priority   = 0;
+	attr->deadline_ns = 0;
+}
+
+int uthread_create_attr(const uthread_attr_t *attr, uthread_func_t func,
+			void *arg)
 {
+	uthread_attr_t default_attr;
+
+	if(attr == NULL) {
+		uthread_attr_init(&default_attr);
+		attr = &default_attr;
+	}
+
+	if(attr->stack_size < UTHREAD_STACK_MIN)
+		return ERROR_FOUND;
+
 	preempt_disable();
 
+	/* Recycle the memory of the threads that exited so far */
+	uthread_reap();
+
 	/* Creating the new thread */
-	uthread_ctx_t *thread_ctx  = malloc(sizeof(uthread_ctx_t));
-	uthread_tcb_t new_thread_t = malloc(sizeof(uthread_tcb));
-	new_thread_t->tid          = num_of_threads;
-	new_thread_t->stack        = uthread_ctx_alloc_stack();
+	uthread_tcb_t new_thread_t = uthread_tcb_alloc();
+	if(new_thread_t == NULL) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	new_thread_t->stack        = uthread_ctx_alloc_stack(attr->stack_size,
+							     attr->stack_mode);
+	new_thread_t->stack_size   = attr->stack_size;
+	new_thread_t->stack_mode   = attr->stack_mode;
 	new_thread_t->state        = READY;
-	new_thread_t->ctx          = *thread_ctx;
+	new_thread_t->state_since  = uthread_now();
+	new_thread_t->se.priority  = attr->priority;
+
+	/* The first activation of the thread starts now */
+	if(attr->deadline_ns != 0) {
+		new_thread_t->se.relative_deadline = attr->deadline_ns;
+		new_thread_t->se.deadline = new_thread_t->state_since +
+					    attr->deadline_ns;
+	}
 
-	/* initalize new thread's execution context */
-	if(uthread_ctx_init(&new_thread_t->ctx, new_thread_t->stack, func, arg))
+	if(attr->name != NULL)
+		strncpy(new_thread_t->name, attr->name, UTHREAD_NAME_MAX - 1);
+
+	/* initalize new thread's execution context, once sure that 
+	   it fits in the ready queue */
+	if(new_thread_t->stack == NULL || sched->reserve(1) ||
+	   uthread_ctx_init(new_thread_t->ctx, new_thread_t->stack,
+			    attr->stack_size, attr->stack_mode, func, arg)) {
+		uthread_ctx_destroy_stack(new_thread_t->stack, attr->stack_size,
+					  attr->stack_mode);
+		uthread_tcb_free(new_thread_t);
+		preempt_enable();
 		return ERROR_FOUND;
+	}
 
 	/* A new thread is successfully created, add it into the ready queue */
-	queue_enqueue(ready_q, new_thread_t);
+	sched->enqueue(new_thread_t);
 	num_of_threads++;
 
 	preempt_enable();
 
+	uthread_preempt_check(new_thread_t);
+
 	return NO_ERROR;
 }
 
+int uthread_create(uthread_func_t func, void *arg)
+{
+	return uthread_create_attr(NULL, func, arg);
+}
+
+/*
+ * uthread_batch_abort - Release a batch of threads that failed to be created
+ * @batch: TCBs of the batch
+ * @count: Number of TCBs allocated in @batch
+ * @slab: Slab of the stacks of the batch
+ *
+ * Must be called with preemption disabled.
+ */
+static void uthread_batch_abort(uthread_tcb_t *batch, size_t count,
+				struct stack_slab *slab)
+{
+	for(size_t i = 0; i < count; i++)
+		uthread_tcb_free(batch[i]);
+
+	free(batch);
+	uthread_slab_release(slab);
+}
+
+int uthread_create_batch(size_t n, const uthread_func_t funcs[],
+			 void *const args[], uthread_t handles[])
+{
+	if(n == 0 || funcs == NULL)
+		return ERROR_FOUND;
+
+	/* The size of the slab must not wrap around */
+	if(n > (SIZE_MAX - sizeof(struct stack_slab)) / UTHREAD_STACK_SIZE)
+		return ERROR_FOUND;
+
+	for(size_t i = 0; i < n; i++)
+		if(funcs[i] == NULL)
+			return ERROR_FOUND;
+
+	preempt_disable();
+
+	uthread_reap();
+
+	/* Make sure the whole batch will fit in the ready queue */
+	if(sched->reserve(n)) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	/* The TCBs of the batch, to be made ready in one operation */
+	uthread_tcb_t *batch = malloc(n * sizeof(*batch));
+	if(batch == NULL) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	/* One allocation for all the stacks of the batch, unless the 
+	   spare slab is large enough */
+	struct stack_slab *slab = spare_slab;
+
+	if(slab != NULL && slab->num_stacks >= n) {
+		spare_slab = NULL;
+	} else {
+		slab = aligned_alloc(CACHE_LINE, sizeof(struct stack_slab) +
+				     n * UTHREAD_STACK_SIZE);
+		if(slab == NULL) {
+			free(batch);
+			preempt_enable();
+			return ERROR_FOUND;
+		}
+		slab->num_stacks = n;
+	}
+
+	char *stacks = (char*) (slab + 1);
+	uint64_t now = uthread_now();
+
+	slab->users = n;
+
+	/* The TCBs come from the arena */
+	for(size_t i = 0; i < n; i++)
+	{
+		batch[i] = uthread_tcb_alloc();
+
+		if(batch[i] == NULL) {
+			uthread_batch_abort(batch, i, slab);
+			preempt_enable();
+			return ERROR_FOUND;
+		}
+	}
+
+	/* Only the first context is captured, the others are copies */
+	for(size_t i = 0; i < n; i++)
+	{
+		uthread_tcb_t tcb = batch[i];
+		void *arg = args != NULL ? args[i] : NULL;
+
+		tcb->stack       = stacks + i * UTHREAD_STACK_SIZE;
+		tcb->stack_size  = UTHREAD_STACK_SIZE;
+		tcb->stack_mode  = UTHREAD_STACK_FIXED;
+		tcb->slab        = slab;
+		tcb->state       = READY;
+		tcb->state_since = now;
+
+		if(i == 0) {
+			if(uthread_ctx_init(tcb->ctx, tcb->stack,
+					    UTHREAD_STACK_SIZE,
+					    UTHREAD_STACK_FIXED, funcs[i],
+					    arg)) {
+				uthread_batch_abort(batch, n, slab);
+				preempt_enable();
+				return ERROR_FOUND;
+			}
+		} else {
+			uthread_ctx_init_from(tcb->ctx, batch[0]->ctx,
+					      tcb->stack, UTHREAD_STACK_SIZE,
+					      funcs[i], arg);
+		}
+
+		if(handles != NULL)
+			handles[i] = uthread_handle(tcb);
+	}
+
+	/* Make the whole batch ready in one operation, if the policy
+	   can, or one thread at a time otherwise */
+	if(sched->enqueue_batch != NULL) {
+		sched->enqueue_batch(batch, n);
+	} else {
+		for(size_t i = 0; i < n; i++)
+			sched->enqueue(batch[i]);
+	}
+	num_of_threads += n;
+
+	free(batch);
+	preempt_enable();
+
+	return NO_ERROR;
+}
+
+void uthread_opts_init(uthread_opts_t *opts)
+{
+	opts->cpus           = NULL;
+	opts->num_cpus       = 0;
+	opts->shared_sigmask = 0;
+	opts->quantum_us     = 0;
+	opts->policy         = UTHREAD_SCHED_FIFO;
+	opts->sched          = NULL;
+}
+
+/*
+ * uthread_sched_lookup - Scheduling policy named by @opts
+ * @opts: Runtime options
+ *
+ * Return: NULL if @opts names no known policy.
+ */
+static const struct uthread_sched_ops *uthread_sched_lookup(
+	const uthread_opts_t *opts)
+{
+	switch(opts->policy) {
+	case UTHREAD_SCHED_FIFO:
+		return &uthread_sched_fifo;
+	case UTHREAD_SCHED_EDF:
+		return &uthread_sched_edf;
+	case UTHREAD_SCHED_FAIR:
+		return &uthread_sched_fair;
+	}
+
+	return NULL;
+}
+
+/*
+ * uthread_pin - Pin the calling kernel thread to the CPUs of @opts
+ * @opts: Runtime options
+ * @saved: Address where to save the previous CPU affinity
+ *
+ * Return: -1 if a CPU of @opts is invalid or cannot be used. 0 otherwise.
+ */
+static int uthread_pin(const uthread_opts_t *opts, cpu_set_t *saved)
+{
+	cpu_set_t cpus;
+
+	CPU_ZERO(&cpus);
+	for(size_t i = 0; i < opts->num_cpus; i++)
+	{
+		if(opts->cpus[i] < 0 || opts->cpus[i] >= CPU_SETSIZE)
+			return ERROR_FOUND;
+		CPU_SET(opts->cpus[i], &cpus);
+	}
+
+	if(CPU_COUNT(&cpus) == 0 ||
+	   sched_getaffinity(0, sizeof(cpu_set_t), saved) ||
+	   sched_setaffinity(0, sizeof(cpu_set_t), &cpus))
+		return ERROR_FOUND;
+
+	return NO_ERROR;
+}
+
+/*
+ * uthread_unpin - Restore the CPU affinity saved by uthread_pin()
+ * @opts: Runtime options
+ * @saved: CPU affinity saved by uthread_pin()
+ */
+static void uthread_unpin(const uthread_opts_t *opts, const cpu_set_t *saved)
+{
+	if(opts->cpus != NULL)
+		sched_setaffinity(0, sizeof(cpu_set_t), saved);
+}
+
+/*
+ * uthread_start_abort - Undo a uthread_start_opts() which failed once its
+ * scheduling policy was initialized
+ * @opts: Runtime options
+ * @saved: CPU affinity saved by uthread_pin()
+ *
+ * Stops preemption, releases the main thread, if any, and the policy, and
+ * restores the CPU affinity.
+ *
+ * Return: -1
+ */
+static int uthread_start_abort(const uthread_opts_t *opts,
+			       const cpu_set_t *saved)
+{
+	preempt_stop();
+
+	if(main_tcb != NULL) {
+		uthread_ctx_destroy_stack(main_tcb->stack, main_tcb->stack_size,
+					  main_tcb->stack_mode);
+		num_of_threads--;
+	}
+	uthread_tcb_release_all();
+	main_tcb    = NULL;
+	current_tcb = NULL;
+
+	sched->fini();
+	sched = &uthread_sched_fifo;
+
+	uthread_unpin(opts, saved);
+
+	return ERROR_FOUND;
+}
+
 int uthread_start(uthread_func_t func, void *arg)
 {
-	/* The queue shd be initialize when the lib is created */
-	ready_q   = queue_create();
-	blocked_q = queue_create();
+	return uthread_start_opts(NULL, func, arg);
+}
 
-	/* Initialize the main thread */
-	uthread_tcb_t main_thread = malloc(sizeof(uthread_tcb));
-	uthread_ctx_t *main_ctx   = malloc(sizeof(uthread_ctx_t));
-	main_thread->tid          = 0;
-	main_thread->state        = READY;
-	main_thread->stack        = uthread_ctx_alloc_stack();
-	main_thread->ctx          = *main_ctx;
+int uthread_start_opts(const uthread_opts_t *opts, uthread_func_t func,
+		       void *arg)
+{
+	const struct uthread_sched_ops *ops;
+	uthread_opts_t default_opts;
+	cpu_set_t saved_cpus;
 
-	/* Initialize main thread's execution context */
-	if(uthread_ctx_init(&main_thread->ctx, main_thread->stack, NULL, NULL))
+	if(opts == NULL) {
+		uthread_opts_init(&default_opts);
+		opts = &default_opts;
+	}
+
+	/* Pin before allocating anything, so that the memory of 
+	   the runtime is first touched from the chosen CPUs */
+	if(opts->cpus != NULL && uthread_pin(opts, &saved_cpus))
 		return ERROR_FOUND;
 
+	/* Must be set before any context gets saved */
+	uthread_ctx_shared_sigmask(opts->shared_sigmask);
+
+	/* The queues shd be initialize when the lib is created, 
+	   the ready one by the chosen scheduling policy, which is
+	   only installed once initialized */
+	ops = opts->sched != NULL ? opts->sched : uthread_sched_lookup(opts);
+	if(ops == NULL || ops->init()) {
+		uthread_unpin(opts, &saved_cpus);
+		return ERROR_FOUND;
+	}
+	sched = ops;
+	tcb_queue_init(&zombie_q);
+
+	/* Initialize the main thread */
+	uthread_tcb_t main_thread = uthread_tcb_alloc();
+	if(main_thread == NULL)
+		return uthread_start_abort(opts, &saved_cpus);
+	main_thread->state        = RUNNING;
+	main_thread->stack        = uthread_ctx_alloc_stack(UTHREAD_STACK_SIZE,
+							    UTHREAD_STACK_FIXED);
+	main_thread->stack_size   = UTHREAD_STACK_SIZE;
+	main_thread->stack_mode   = UTHREAD_STACK_FIXED;
+	main_thread->state_since  = uthread_now();
+
 	num_of_threads++;
 
 	/* Store the address of main_tcb globally */
 	main_tcb = main_thread;
 
+	/* Initialize main thread's execution context */
+	if(main_thread->stack == NULL ||
+	   uthread_ctx_init(main_thread->ctx, main_thread->stack,
+			    UTHREAD_STACK_SIZE, UTHREAD_STACK_FIXED, NULL, NULL))
+		return uthread_start_abort(opts, &saved_cpus);
+
 	/* At this moment, the main thread is the current Running thread */
 	current_tcb = main_tcb;
 
 	/* The function preempt_start() should be called when the 
 	   uthread library is initializing and sets up preemption. */
-	preempt_start();
+	preempt_start(opts->shared_sigmask, opts->quantum_us);
 
 	/* Create an initial thread and start the multithreading process */
 	if(uthread_create(func, arg))
-		return ERROR_FOUND;
+		return uthread_start_abort(opts, &saved_cpus);
 
 	/* Start Multithread Scheduling by executing an infinite loop 
-	   the loop will break if there is no more threads Ready */
-	while(queue_length(ready_q))
+	   the loop will break if there is no more threads Ready nor 
+	   tasks pending. Each turn runs one task, if any, so that 
+	   tasks and threads are interleaved */
+	while(sched->nr_ready() || task_head != NULL)
 	{	
+		uthread_run_task();
 		uthread_yield();
+
+		preempt_disable();
+		uthread_reap();
+		preempt_enable();
+	}
+
+	preempt_disable();
+	uthread_reap();
+	preempt_enable();
+
+	/* Release the tasks kept for reuse */
+	while(free_tasks != NULL) {
+		struct uthread_task *task = free_tasks;
+
+		free_tasks = task->next;
+		free(task);
 	}
 
 	/* Destroy the queue before leaving the library */
-	queue_destroy(ready_q);
-	queue_destroy(blocked_q);
+	sched->fini();
+	sched = &uthread_sched_fifo;
+
+	free(spare_slab);
+	spare_slab = NULL;
+
+	/* Release the TCBs, including the main thread's */
+	uthread_ctx_destroy_stack(main_tcb->stack, main_tcb->stack_size,
+				  main_tcb->stack_mode);
+	uthread_tcb_release_all();
+	main_tcb    = NULL;
+	current_tcb = NULL;
 
 	/* preempt_stop() should be called before uthread_start() return */
 	preempt_stop();
 
+	uthread_unpin(opts, &saved_cpus);
+
 	/* No problems were detected so report perfect execution */
 	return NO_ERROR;
 }
@@ -275,20 +1193,21 @@ void uthread_block(void)
 {
 	preempt_disable();
 
-	/* Add current running thread to block queue */
-	current_tcb->state = BLOCKED;
-	queue_enqueue(blocked_q, current_tcb);
+	/* Blocked threads are not kept in any queue: whoever is to
+	   unblock the running thread keeps track of it, and its state
+	   tells whether it is still blocked. Parking and unparking 
+	   are thus O(1), however many threads are blocked. */
 
 	/* When current_tcb is blocked, we shd switch to next_tcb */
-	uthread_tcb_t next_tcb = malloc(sizeof(uthread_tcb));
+	uthread_tcb_t next_tcb;
 
 	/* Get next_tcb and set it to be current Running Thread */
-	queue_dequeue(ready_q, (void**) &next_tcb);
-	next_tcb->state = RUNNING;
-	uthread_tcb_t temp = current_tcb;
-	current_tcb = next_tcb;
+	next_tcb = sched->pick_next();
 
-	uthread_ctx_switch(&temp->ctx, &current_tcb->ctx);
+	if(sched->on_block != NULL)
+		sched->on_block(current_tcb);
+
+	uthread_switch(BLOCKED, next_tcb, false);
 
 	preempt_enable();
 }
@@ -297,32 +1216,154 @@ void uthread_unblock(struct uthread_tcb *uthread)
 {
 	preempt_disable();
 	
-	int len = queue_length(blocked_q);
-	uthread_tcb_t temp = malloc(sizeof(uthread_tcb));
+	/* Unpark uthread, if it is blocked, and enqueue it to 
+	   the back of the Ready_q */
+	if(uthread->state == BLOCKED) {
+		uint64_t now = uthread_now();
 
-	/* Keep iterating the block_q until we find uthread
-	   or until len == 0 */
-	while(len) 
-	{
-		/* Store extracted thread to temp */
-		queue_dequeue(blocked_q, (void **) &temp);
-
-		/* Enqueue uthread to the back of the Ready_q */
-		if(temp->tid == uthread->tid) {
-			uthread->state = READY;
-			queue_enqueue(ready_q, uthread);
-			break;
-		}
-		
-		/* Keep looping since temp is not uthread */
-		queue_enqueue(blocked_q, temp);
-		len--;
+		/* Waking up starts a new activation of the thread */
+		if(uthread->se.relative_deadline != 0)
+			uthread->se.deadline = now + uthread->se.relative_deadline;
+
+		if(sched->on_wake != NULL)
+			sched->on_wake(uthread);
+
+		uthread_set_state(uthread, READY, now);
+		sched->enqueue(uthread);
 	}
 
 	preempt_enable();
+
+	uthread_preempt_check(uthread);
 }
 
 uthread_tcb_t uthread_current(void)
 {
 	return current_tcb;
 }
+
+bool uthread_runnable(uthread_tcb_t uthread)
+{
+	return uthread->state == READY || uthread->state == RUNNING;
+}
+
+struct uthread_waiter *uthread_waiter(uthread_tcb_t uthread)
+{
+	return &uthread->waiter;
+}
+
+uthread_t uthread_self(void)
+{
+	if(current_tcb == NULL)
+		return 0;
+
+	return uthread_handle(current_tcb);
+}
+
+int uthread_alive(uthread_t thread)
+{
+	preempt_disable();
+	uthread_tcb_t tcb = uthread_lookup(thread);
+	preempt_enable();
+
+	return tcb != NULL;
+}
+
+int uthread_set_deadline(uint64_t relative_ns)
+{
+	bool preempt;
+
+	if(current_tcb == NULL)
+		return ERROR_FOUND;
+
+	preempt_disable();
+
+	current_tcb->se.relative_deadline = relative_ns;
+	current_tcb->se.deadline = relative_ns != 0 ?
+				   uthread_now() + relative_ns : UTHREAD_NO_DEADLINE;
+
+	/* A later deadline may leave a ready thread more urgent */
+	preempt = sched->check_deadline != NULL &&
+		  sched->check_deadline(current_tcb);
+
+	preempt_enable();
+
+	if(preempt)
+		uthread_yield_current(true);
+
+	return NO_ERROR;
+}
+
+const char *uthread_name(void)
+{
+	if(current_tcb == NULL || current_tcb->name[0] == '\0')
+		return NULL;
+
+	return current_tcb->name;
+}
+
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *))
+{
+	if(key == NULL)
+		return ERROR_FOUND;
+
+	preempt_disable();
+
+	if(num_of_keys == UTHREAD_KEYS_MAX) {
+		preempt_enable();
+		return ERROR_FOUND;
+	}
+
+	key_destructors[num_of_keys] = destructor;
+	*key = num_of_keys++;
+
+	preempt_enable();
+
+	return NO_ERROR;
+}
+
+void *uthread_getspecific(uthread_key_t key)
+{
+	if(key >= num_of_keys || current_tcb == NULL)
+		return NULL;
+
+	return current_tcb->specific[key];
+}
+
+int uthread_setspecific(uthread_key_t key, const void *value)
+{
+	if(key >= num_of_keys || current_tcb == NULL)
+		return ERROR_FOUND;
+
+	current_tcb->specific[key] = (void*) value;
+
+	return NO_ERROR;
+}
+
+int uthread_stats(struct uthread_stats *stats)
+{
+	if(stats == NULL || current_tcb == NULL)
+		return ERROR_FOUND;
+
+	preempt_disable();
+
+	/* Include the time spent running since the last switch */
+	*stats = current_tcb->stats;
+	stats->cpu_time_ns += uthread_now() - current_tcb->state_since;
+
+	preempt_enable();
+
+	return NO_ERROR;
+}
+
+int uthread_stats_total(struct uthread_stats *stats)
+{
+	if(stats == NULL)
+		return ERROR_FOUND;
+
+	preempt_disable();
+	*stats = total_stats;
+	preempt_enable();
+
+	return NO_ERROR;
+}
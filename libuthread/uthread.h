@@ -1,12 +1,83 @@
 #ifndef _UTHREAD_H
 #define _UTHREAD_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*
  * uthread_func_t - Thread function type
  * @arg: Argument to be passed to the thread
  */
 typedef void (*uthread_func_t)(void *arg);
 
+/* Default size of the stack of a thread (in bytes) */
+#define UTHREAD_STACK_SIZE 32768
+
+/* Size of the stack shared by UTHREAD_STACK_SHARED threads (in bytes) */
+#define UTHREAD_SHARED_STACK_SIZE (256 * 1024)
+
+/*
+ * Smallest stack size accepted for a thread (in bytes). A preemption signal is
+ * delivered on the stack of the running thread, and its frame together with
+ * the context switch it leads to takes up to about 4 KiB on x86-64, leaving
+ * the thread about as much for its own frames.
+ */
+#define UTHREAD_STACK_MIN 8192
+
+/* Maximum length of a thread's name, including the terminating null byte */
+#define UTHREAD_NAME_MAX 16
+
+/*
+ * uthread_stack_mode - How a thread's stack is backed by memory
+ *
+ * UTHREAD_STACK_FIXED: The whole stack is allocated at creation.
+ * UTHREAD_STACK_GROWABLE: The stack is only reserved at creation, and its
+ *	pages are committed on demand as the stack grows, up to the stack size.
+ *	The lowest page is kept as a guard page.
+ * UTHREAD_STACK_SHARED: The thread runs on a stack shared by all the threads
+ *	of this mode, of UTHREAD_SHARED_STACK_SIZE bytes. When another thread
+ *	needs the shared stack, the used part of it is copied to a buffer sized
+ *	to fit, and copied back when the thread runs again. The stack size
+ *	attribute is ignored.
+ */
+enum uthread_stack_mode {
+	UTHREAD_STACK_FIXED,
+	UTHREAD_STACK_GROWABLE,
+	UTHREAD_STACK_SHARED,
+};
+
+/*
+ * uthread_attr_t - Thread creation attributes
+ * @stack_size: Size of the thread's stack, in bytes. For a growable stack, this
+ *	is the size of the reserved range, ie the limit up to which it can grow
+ *	(for example 1 MiB), and it must be a multiple of the page size.
+ * @stack_mode: How the thread's stack is backed by memory
+ * @name: Name of the thread, for debugging purposes, or NULL. The name is
+ *	copied and truncated to UTHREAD_NAME_MAX - 1 characters.
+ * @priority: Scheduling hint, a higher value meaning a more important thread.
+ *	Sets the weight of the thread with UTHREAD_SCHED_FAIR, from -19 to 20.
+ *	Ignored by policies which do not use it.
+ * @deadline_ns: Relative deadline of each activation of the thread, in
+ *	nanoseconds, or 0 for none. See uthread_set_deadline(). Ignored by
+ *	policies other than UTHREAD_SCHED_EDF.
+ */
+typedef struct uthread_attr {
+	size_t stack_size;
+	enum uthread_stack_mode stack_mode;
+	const char *name;
+	int priority;
+	uint64_t deadline_ns;
+} uthread_attr_t;
+
+/*
+ * uthread_attr_init - Initialize thread creation attributes
+ * @attr: Attributes to initialize
+ *
+ * Set @attr to the attributes used by uthread_create(): a fixed stack of
+ * UTHREAD_STACK_SIZE bytes, no name, a priority of 0 and no deadline.
+ */
+void uthread_attr_init(uthread_attr_t *attr);
+
 /*
  * uthread_start - Start the multithreading library
  * @func: Function of the first thread to start
@@ -21,6 +92,92 @@ typedef void (*uthread_func_t)(void *arg);
  */
 int uthread_start(uthread_func_t func, void *arg);
 
+/*
+ * uthread_sched_policy - How the next thread to run is chosen
+ *
+ * UTHREAD_SCHED_FIFO: Ready threads run in turns, in the order in which they
+ *	became ready.
+ * UTHREAD_SCHED_EDF: Earliest deadline first. The ready thread whose current
+ *	activation has the earliest absolute deadline runs first, the threads
+ *	without a deadline running after all the others, in turns. A thread
+ *	becoming ready with an earlier deadline than the running thread
+ *	preempts it right away, and a preemption tick only switches to a thread
+ *	of deadline as early as the running one. uthread_yield() still gives
+ *	way to the first ready thread, whatever its deadline.
+ * UTHREAD_SCHED_FAIR: Fair share. Each thread accrues virtual runtime, its
+ *	CPU time divided by its weight, and the ready thread of least virtual
+ *	runtime runs first. The weight of a thread follows its priority, each
+ *	step of priority being worth about 25% more CPU time. A thread keeps
+ *	the CPU, even when it yields, while its virtual runtime is the least.
+ *	A thread waking up gets a bounded credit of virtual runtime, and
+ *	preempts the running thread if it is enough behind it.
+ */
+enum uthread_sched_policy {
+	UTHREAD_SCHED_FIFO,
+	UTHREAD_SCHED_EDF,
+	UTHREAD_SCHED_FAIR,
+};
+
+struct uthread_sched_ops;
+
+/*
+ * uthread_opts_t - Runtime options
+ * @cpus: CPUs the runtime may run on, or NULL to leave the CPU affinity of the
+ *	process untouched. All the threads of the library run on the kernel
+ *	thread calling uthread_start_opts(), which is pinned to these CPUs until
+ *	uthread_start_opts() returns. As the stacks and TCBs are first touched
+ *	by that kernel thread, the kernel backs them with memory local to the
+ *	NUMA node of these CPUs: pinning to CPUs of a single node keeps the
+ *	runtime off the other sockets.
+ * @num_cpus: Number of CPUs in @cpus
+ * @shared_sigmask: Treat the signal mask as process-wide, i.e. the same for
+ *	all the threads. Context switches then never save nor restore it, which
+ *	saves a system call per switch, and preemption is disabled within the
+ *	library by a flag rather than by masking the timer signal. Threads must
+ *	not change the signal mask themselves in this mode.
+ * @quantum_us: Time slice after which a thread is preempted, in microseconds
+ *	of CPU time of the kernel thread running the runtime, or 0 for the
+ *	default of 1 ms. The preemption timer only interrupts that kernel
+ *	thread, whatever other kernel threads the process runs.
+ * @policy: Scheduling policy of the runtime
+ * @sched: Custom scheduling policy, as a table of operations implementing
+ *	struct uthread_sched_ops of private.h, overriding @policy, or NULL. The
+ *	table must outlive uthread_start_opts().
+ */
+typedef struct uthread_opts {
+	const int *cpus;
+	size_t num_cpus;
+	int shared_sigmask;
+	unsigned quantum_us;
+	enum uthread_sched_policy policy;
+	const struct uthread_sched_ops *sched;
+} uthread_opts_t;
+
+/*
+ * uthread_opts_init - Initialize runtime options
+ * @opts: Options to initialize
+ *
+ * Set @opts to the options used by uthread_start(): no CPU pinning, a signal
+ * mask saved and restored with each thread, the default time slice, and the
+ * UTHREAD_SCHED_FIFO policy.
+ */
+void uthread_opts_init(uthread_opts_t *opts);
+
+/*
+ * uthread_start_opts - Start the multithreading library with options
+ * @opts: Runtime options, or NULL for the default options
+ * @func: Function of the first thread to start
+ * @arg: Argument to be passed to the first thread
+ *
+ * Same as uthread_start(), except that the runtime is set up according to
+ * @opts.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation, invalid or unavailable CPU in @opts).
+ */
+int uthread_start_opts(const uthread_opts_t *opts, uthread_func_t func,
+		       void *arg);
+
 /*
  * uthread_create - Create a new thread
  * @func: Function to be executed by the thread
@@ -34,6 +191,103 @@ int uthread_start(uthread_func_t func, void *arg);
  */
 int uthread_create(uthread_func_t func, void *arg);
 
+/*
+ * uthread_create_attr - Create a new thread with specific attributes
+ * @attr: Attributes of the new thread, or NULL for the default attributes
+ * @func: Function to be executed by the thread
+ * @arg: Argument to be passed to the thread
+ *
+ * Same as uthread_create(), except that the new thread is set up according to
+ * @attr.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory allocation,
+ * context creation, stack size smaller than UTHREAD_STACK_MIN).
+ */
+int uthread_create_attr(const uthread_attr_t *attr, uthread_func_t func,
+			void *arg);
+
+/*
+ * uthread_t - Thread handle
+ *
+ * Identifies a thread created by the library. A handle remains safe to use
+ * after its thread exited: it is then recognized as stale, even once the
+ * memory of the thread was reused by another thread. 0 is never a valid
+ * handle.
+ */
+typedef uint64_t uthread_t;
+
+/*
+ * uthread_create_batch - Create many threads at once
+ * @n: Number of threads to create
+ * @funcs: Function to be executed by each thread
+ * @args: Argument to be passed to each thread, or NULL to pass NULL to all
+ * @handles: Address where to store the handle of each thread, or NULL
+ *
+ * Same as calling uthread_create() @n times, but cheaper: the stacks of the
+ * whole batch are carved out of a single allocation, which is released once
+ * all these threads exited, and the batch is made ready at the end of the
+ * call, in a single operation when the policy supports it. With the FIFO
+ * policy, the threads run in the order of @funcs.
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory
+ * allocation, context creation), in which case no thread is created.
+ */
+int uthread_create_batch(size_t n, const uthread_func_t funcs[],
+			 void *const args[], uthread_t handles[]);
+
+/*
+ * uthread_self - Get the handle of the currently running thread
+ *
+ * Return: Handle of the running thread, or 0 if the library is not started
+ */
+uthread_t uthread_self(void);
+
+/*
+ * uthread_alive - Check whether a thread still exists
+ * @thread: Handle of the thread
+ *
+ * Return: 1 if @thread designates a thread which did not exit yet, 0 if it
+ * exited or if @thread is not a valid handle
+ */
+int uthread_alive(uthread_t thread);
+
+/*
+ * uthread_set_deadline - Declare the deadline of the running thread
+ * @relative_ns: Relative deadline, in nanoseconds, or 0 for none
+ *
+ * The current activation of the running thread is due within @relative_ns
+ * from now. Each later activation, which starts whenever the thread is
+ * unblocked (e.g., by sem_up()), is due within @relative_ns from its wake-up.
+ * Deadlines only matter to the UTHREAD_SCHED_EDF policy.
+ *
+ * Return: -1 if the library is not started, 0 otherwise.
+ */
+int uthread_set_deadline(uint64_t relative_ns);
+
+/*
+ * uthread_name - Get the name of the currently running thread
+ *
+ * Return: Name given to the running thread at creation, or NULL if it has no
+ * name.
+ */
+const char *uthread_name(void);
+
+/*
+ * uthread_spawn_task - Queue a run-to-completion task
+ * @func: Function to be executed by the task
+ * @arg: Argument to be passed to the task
+ *
+ * Unlike a thread, a task has neither a stack nor an execution context of its
+ * own: it is run directly on the stack of the main execution thread, which
+ * runs one pending task each time it is scheduled, in between the other
+ * threads. A task must therefore run to completion: it must neither block
+ * (e.g., on a semaphore) nor call uthread_exit().
+ *
+ * Return: 0 in case of success, -1 in case of failure (e.g., memory
+ * allocation).
+ */
+int uthread_spawn_task(uthread_func_t func, void *arg);
+
 /*
  * uthread_yield - Yield execution
  *
@@ -42,6 +296,22 @@ int uthread_create(uthread_func_t func, void *arg);
  */
 void uthread_yield(void);
 
+/*
+ * uthread_yield_to - Yield execution to a given thread
+ * @thread: Handle of the ready thread to run next
+ *
+ * Switch straight to @thread, taking it out of its place among the ready
+ * threads, instead of to the next thread of the scheduling policy. With the
+ * UTHREAD_SCHED_FIFO policy, the calling thread takes the place @thread had
+ * in line, so that the other ready threads do not wait any longer. With the
+ * other policies, it is made ready as by uthread_yield().
+ *
+ * Return: -1 if @thread is not a ready thread, e.g. it is the calling thread,
+ * is blocked or exited, in which case the calling thread keeps running. 0
+ * once the calling thread got to run again after @thread.
+ */
+int uthread_yield_to(uthread_t thread);
+
 /*
  * uthread_exit - Exit from currently running thread
  *
@@ -52,4 +322,87 @@ void uthread_yield(void);
  */
 void uthread_exit(void);
 
+/* Maximum number of uthread-local storage keys */
+#define UTHREAD_KEYS_MAX 16
+
+/*
+ * uthread_key_t - Uthread-local storage key
+ *
+ * A key designates one slot of data private to each thread. All the threads
+ * see the same key, but each of them reads and writes its own value.
+ */
+typedef unsigned int uthread_key_t;
+
+/*
+ * uthread_key_create - Create a uthread-local storage key
+ * @key: Address where to store the new key
+ * @destructor: Function called on a thread's non-NULL value when this thread
+ *	exits, or NULL
+ *
+ * The value associated to the new key is initially NULL in every thread.
+ *
+ * Return: -1 if @key is NULL or if UTHREAD_KEYS_MAX keys were already
+ * created. 0 if the key was successfully created.
+ */
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *));
+
+/*
+ * uthread_getspecific - Get the running thread's value for a key
+ * @key: Key created with uthread_key_create()
+ *
+ * Return: Value associated to @key by the currently running thread. NULL if
+ * no value was set, or if @key is invalid.
+ */
+void *uthread_getspecific(uthread_key_t key);
+
+/*
+ * uthread_setspecific - Set the running thread's value for a key
+ * @key: Key created with uthread_key_create()
+ * @value: Value to associate to @key
+ *
+ * Return: -1 if @key is invalid or if no thread is running. 0 if the value was
+ * successfully set.
+ */
+int uthread_setspecific(uthread_key_t key, const void *value);
+
+/*
+ * uthread_stats - Thread runtime statistics
+ * @cpu_time_ns: Time spent running, in nanoseconds
+ * @ready_time_ns: Time spent waiting in the ready queue, in nanoseconds
+ * @blocked_time_ns: Time spent blocked, in nanoseconds
+ * @voluntary_switches: Number of times the thread gave the CPU away by
+ *	yielding or blocking
+ * @involuntary_switches: Number of times the thread was switched out by
+ *	preemption
+ * @preemptions: Number of preemption ticks received by the thread, whether or
+ *	not another thread was ready to take over
+ */
+struct uthread_stats {
+	uint64_t cpu_time_ns;
+	uint64_t ready_time_ns;
+	uint64_t blocked_time_ns;
+	uint64_t voluntary_switches;
+	uint64_t involuntary_switches;
+	uint64_t preemptions;
+};
+
+/*
+ * uthread_stats - Get statistics of the currently running thread
+ * @stats: Address where to copy the statistics
+ *
+ * Return: -1 if @stats is NULL or if the library is not started, 0 otherwise.
+ */
+int uthread_stats(struct uthread_stats *stats);
+
+/*
+ * uthread_stats_total - Get statistics of the whole runtime
+ * @stats: Address where to copy the statistics
+ *
+ * The returned counters are the sum of the counters of all the threads ever
+ * run by the library, including the threads that have already exited.
+ *
+ * Return: -1 if @stats is NULL, 0 otherwise.
+ */
+int uthread_stats_total(struct uthread_stats *stats);
+
 #endif /* _UTHREAD_H */